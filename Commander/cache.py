@@ -0,0 +1,106 @@
+# Tesselator commander - result cache
+# https://github.com/invpe/Tesselator
+#
+# Content-addressed store of task outputs. The key is a hash over the task binary,
+# its payloads and its argument, so rerunning an overlapping sweep only computes
+# the triples that were never run before. Entries are plain files under the cache
+# directory; their modification time is bumped on every hit and the least recently
+# used ones are evicted once the cache grows past its size limit. The entries' sizes
+# and recency are indexed in memory when the cache is opened, so storing an output
+# does not scan the directory.
+import hashlib
+import os
+import shutil
+import threading
+from collections import OrderedDict
+
+class ResultCache:
+    def __init__(self, directory, max_bytes):
+        self.directory = directory
+        self.max_bytes = max_bytes
+        self.lock = threading.Lock()
+        os.makedirs(directory, exist_ok=True)
+        # path -> size of every entry, least recently used first, and their total size
+        self.index = OrderedDict((path, size) for path, size, _ in sorted(self.entries(), key=lambda entry: entry[2]))
+        self.total = sum(self.index.values())
+
+    @staticmethod
+    def key(binary_hash, payloads, argument):
+        """Cache key of a task: binary hash, every payload's hash and the argument.
+
+        `payloads` maps names to objects with a sha256() method returning the digest.
+        """
+        h = hashlib.sha256()
+        h.update(binary_hash.encode())
+        for name in sorted(payloads):
+            h.update(payloads[name].sha256())
+        h.update(b"\0" if argument is None else b"\1" + argument.encode())
+        return h.hexdigest()
+
+    def path(self, key):
+        return os.path.join(self.directory, key[:2], key)
+
+    def lookup(self, key, output_path):
+        """Copy the cached output for `key` to `output_path`, returns False on a miss."""
+        cached = self.path(key)
+        # Copy outside the lock; entries are replaced atomically, and one evicted meanwhile is a miss
+        try:
+            shutil.copyfile(cached, output_path)
+            os.utime(cached)  # Mark as recently used, for the index of the next run
+        except FileNotFoundError:
+            return False
+        with self.lock:
+            if cached in self.index:
+                self.index.move_to_end(cached)
+        return True
+
+    def store(self, key, output_path):
+        cached = self.path(key)
+        os.makedirs(os.path.dirname(cached), exist_ok=True)
+        # Copy outside the lock, under a name of this thread's own
+        temporary = f"{cached}.{threading.get_ident()}.tmp"
+        shutil.copyfile(output_path, temporary)
+        size = os.path.getsize(temporary)
+        with self.lock:
+            os.replace(temporary, cached)
+            self.total += size - self.index.pop(cached, 0)
+            self.index[cached] = size
+            if self.total > self.max_bytes:
+                self.evict()
+
+    def entries(self):
+        for sub in os.listdir(self.directory):
+            subdir = os.path.join(self.directory, sub)
+            if not os.path.isdir(subdir):
+                continue
+            for name in os.listdir(subdir):
+                if name.endswith(".tmp"):
+                    continue
+                path = os.path.join(subdir, name)
+                stat = os.stat(path)
+                yield path, stat.st_size, stat.st_mtime
+
+    def evict(self):
+        """Remove least recently used entries until the cache fits its size limit, called with the lock held."""
+        while self.total > self.max_bytes and self.index:
+            path, size = self.index.popitem(last=False)
+            try:
+                os.remove(path)
+            except FileNotFoundError:
+                pass
+            self.total -= size
+
+    def clear(self):
+        """Invalidate every entry, returns how many were removed."""
+        with self.lock:
+            removed = 0
+            for path, _, _ in list(self.entries()):
+                os.remove(path)
+                removed += 1
+            self.index.clear()
+            self.total = 0
+            return removed
+
+    def stats(self):
+        with self.lock:
+            return len(self.index), self.total
@@ -0,0 +1,378 @@
+# Tesselator commander - cluster scale benchmark
+# https://github.com/invpe/Tesselator
+#
+# Runs tessie.py against hundreds of simulated nodes on loopback and reports how the
+# commander copes: tasks per second, makespan, the commander's CPU use and how much of
+# the time the nodes sat idle. Every simulated node listens on its own 127.x.y.z address
+# with its own bandwidth, latency, speed, failure and reboot behaviour, and serves the
+# node protocol one request at a time like an ESP32 does, all from one asyncio loop.
+#
+# Runs are seeded, so the same command builds the same cluster and draws faults from the
+# same sequence; keep the JSON of a good run and pass it as --baseline to catch regressions.
+import argparse
+import asyncio
+import json
+import os
+import random
+import socket
+import statistics
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+BROADCAST_PORT = 1911
+COMMANDER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "tessie.py")
+NODE_NETWORK = "127.1"  # Simulated nodes get 127.1.x.y, clear of the commander's 127.0.0.1
+SPIFFS_BYTES = 1441792
+
+# Standard workloads, each one stresses a different part of the commander
+WORKLOADS = {
+    "sweep": {"tasks": 1000, "compute": 0.5, "help": "parameter sweep, one argument per task"},
+    "sharded": {"shard_mb": 32, "compute_per_kb": 0.002, "help": "a large file split into shards, time per payload byte"},
+    "tiny": {"tasks": 5000, "compute": 0.002, "help": "many tiny tasks, dominated by per task overhead"},
+}
+
+def parse_size(text):
+    """Bytes from '100k', '2M' or a plain number."""
+    units = {"k": 1024, "m": 1024 ** 2, "g": 1024 ** 3}
+    text = str(text).strip().lower()
+    if text and text[-1] in units:
+        return float(text[:-1]) * units[text[-1]]
+    return float(text)
+
+class SimNode:
+    """One simulated node: HTTP server, beacon and the node's state."""
+    def __init__(self, index, address, config, rng):
+        self.index = index
+        self.address = address
+        self.config = config
+        self.rng = rng
+        self.bandwidth = config.bandwidth * rng.uniform(1 - config.spread, 1 + config.spread)
+        self.speed = rng.uniform(1 - config.spread, 1 + config.spread)  # Compute time multiplier
+        self.lock = asyncio.Lock()  # The ESP32 serves one request at a time, the running task included
+        self.busy = False
+        self.down_until = 0.0
+        self.executed = 0
+        self.payload_bytes = 0
+        self.argument = ""
+        self.has_output = False
+        self.compute_seconds = 0.0
+        self.failures = 0
+        self.reboots = 0
+        self.first_request = None
+        self.last_output = None
+        self.outputs = 0
+
+    def down(self):
+        return time.time() < self.down_until
+
+    async def serve(self, reader, writer):
+        try:
+            head = await reader.readuntil(b"\r\n\r\n")
+            lines = head.decode("latin-1").split("\r\n")
+            method, path = lines[0].split(" ")[:2]
+            path = path.split("?")[0]
+            length = 0
+            for line in lines[1:]:
+                name, _, value = line.partition(":")
+                if name.strip().lower() == "content-length":
+                    length = int(value)
+
+            async with self.lock:
+                if self.down() or self.rng.random() < self.config.failure_rate:
+                    if not self.down():
+                        self.failures += 1
+                    writer.transport.abort()  # Gone mid request, like a dropped WiFi link
+                    return
+                if self.first_request is None:
+                    self.first_request = time.time()
+                await asyncio.sleep(self.config.latency)
+                started = time.time()
+                body = await reader.readexactly(length) if length else b""
+                await asyncio.sleep(max(0.0, len(body) / self.bandwidth - (time.time() - started)))
+                await self.handle(method, path, body, writer)
+        except (asyncio.IncompleteReadError, ConnectionError, ValueError):
+            pass
+        finally:
+            writer.close()
+
+    async def respond(self, writer, code, body, content_type="application/json"):
+        if isinstance(body, str):
+            body = body.encode()
+        reason = {200: "OK", 404: "Not Found"}.get(code, "Internal Server Error")
+        writer.write(f"HTTP/1.1 {code} {reason}\r\nContent-Type: {content_type}\r\nContent-Length: {len(body)}\r\n"
+                     f"Connection: close\r\n\r\n".encode() + body)
+        await writer.drain()
+
+    async def handle(self, method, path, body, writer):
+        if path == "/uploadbin":
+            self.argument = ""
+            await self.respond(writer, 200, '{"status": "success", "message": "Binary upload complete"}')
+        elif path == "/uploadpayload":
+            self.argument = ""
+            self.payload_bytes = len(body)
+            await self.respond(writer, 200, '{"status": "success", "message": "Payload upload complete"}')
+        elif path == "/arg":
+            self.argument = body.decode(errors="replace")
+            await self.respond(writer, 200, json.dumps({"status": "ok", "argument": self.argument}))
+        elif path == "/status":
+            await self.respond(writer, 200, '{"status": "busy"}' if self.busy else '{"status": "available"}')
+        elif path == "/output":
+            if not self.has_output:
+                await self.respond(writer, 500, '{"status": "error", "message": "Output file not found"}')
+                return
+            output = f"sim output of {self.argument or 'task'} from {self.address}\n".encode()
+            output = output.ljust(self.config.output_bytes, b".")
+            await asyncio.sleep(len(output) / self.bandwidth)
+            await self.respond(writer, 200, output, "application/octet-stream")
+            self.last_output = time.time()
+            self.outputs += 1
+        elif path == "/execute":
+            await self.execute(writer)
+        else:
+            await self.respond(writer, 404, f"Not found: {path}", "text/plain")
+
+    async def execute(self, writer):
+        self.busy = True
+        self.has_output = False
+        await self.respond(writer, 200, '{"status": "success", "message": "Task started"}')
+        writer.close()
+
+        seconds = (self.config.compute + self.config.compute_per_kb * self.payload_bytes / 1024) * self.speed
+        seconds *= self.rng.lognormvariate(0, self.config.jitter) if self.config.jitter else 1.0
+        if self.rng.random() < self.config.reboot_rate:
+            # Crash part way through, lose the task and everything on SPIFFS, come back after a while
+            await asyncio.sleep(seconds * self.rng.random())
+            self.reboots += 1
+            self.down_until = time.time() + self.config.reboot_seconds
+            self.executed = 0
+            self.busy = False
+            return
+        await asyncio.sleep(seconds)
+        self.compute_seconds += seconds
+        self.executed += 1
+        self.has_output = True
+        self.busy = False
+
+    def beacon(self):
+        free = SPIFFS_BYTES - self.payload_bytes
+        return json.dumps({"node": "TESSIE_NODE", "mac": f"02:00:00:00:{self.index >> 8:02X}:{self.index & 0xff:02X}",
+                           "total_executed": self.executed, "status": "busy" if self.busy else "available",
+                           "free_spiffs_bytes": free, "rssi": -40}).encode()
+
+class SimCluster:
+    """Simulated nodes served from one asyncio loop in a background thread."""
+    def __init__(self, config):
+        self.config = config
+        rng = random.Random(config.seed)
+        self.nodes = [SimNode(index, f"{NODE_NETWORK}.{index // 250}.{index % 250 + 1}", config,
+                              random.Random(rng.random())) for index in range(config.nodes)]
+        self.loop = asyncio.new_event_loop()
+        self.ready = threading.Event()
+        self.thread = threading.Thread(target=self.run, daemon=True)
+        self.servers = []
+        self.error = None
+
+    def start(self):
+        self.thread.start()
+        self.ready.wait()
+        if self.error:
+            raise self.error
+
+    def stop(self):
+        self.loop.call_soon_threadsafe(self.loop.stop)
+        self.thread.join()
+        # Close the listening sockets and finish the node handlers, so the next run can bind the addresses again
+        for server in self.servers:
+            server.close()
+        tasks = asyncio.all_tasks(self.loop)
+        for task in tasks:
+            task.cancel()
+        self.loop.run_until_complete(asyncio.gather(*tasks, return_exceptions=True))
+        self.loop.close()
+
+    def run(self):
+        asyncio.set_event_loop(self.loop)
+        try:
+            for node in self.nodes:
+                self.servers.append(self.loop.run_until_complete(
+                    asyncio.start_server(node.serve, node.address, 80, backlog=64)))
+        except OSError as e:
+            self.error = e
+            self.ready.set()
+            return
+        self.loop.create_task(self.beacons())
+        self.ready.set()
+        self.loop.run_forever()
+
+    async def beacons(self):
+        sockets = []
+        for node in self.nodes:
+            sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+            sock.bind((node.address, 0))
+            sock.setblocking(False)
+            sockets.append(sock)
+        # Spread the beacons over the interval, like nodes booted at different times
+        step = self.config.beacon_interval / max(len(self.nodes), 1)
+        try:
+            while True:
+                for node, sock in zip(self.nodes, sockets):
+                    if not node.down():
+                        try:
+                            sock.sendto(node.beacon(), ("127.0.0.1", BROADCAST_PORT))
+                        except OSError:
+                            pass
+                    await asyncio.sleep(step)
+        finally:
+            for sock in sockets:
+                sock.close()
+
+def make_workload(name, config, directory):
+    """The tessie.py arguments of a workload and its number of tasks."""
+    binary = os.path.join(directory, "task.elf")
+    with open(binary, "wb") as f:
+        f.write(random.Random(config.seed).randbytes(int(config.binary_bytes)))
+    arguments = ["-b", binary, "--results-dir", os.path.join(directory, "results")]
+    if name == "sharded":
+        path = os.path.join(directory, "samples.txt")
+        rng = random.Random(config.seed)
+        target = config.shard_mb * 1024 * 1024
+        with open(path, "w") as f:
+            written = 0
+            while written < target:
+                line = f"{rng.random():.6f} {rng.random():.6f}\n"
+                f.write(line)
+                written += len(line)
+        arguments += ["-s", path]
+        return arguments, None
+    tasks = config.tasks
+    return arguments + ["-a"] + [f"{name}_{index}" for index in range(tasks)], tasks
+
+def run_once(name, config):
+    cluster = SimCluster(config)
+    cluster.start()
+    with tempfile.TemporaryDirectory(prefix="tessie_bench_") as directory:
+        arguments, tasks = make_workload(name, config, directory)
+        if config.max_concurrency:
+            arguments += ["--max-concurrency", str(config.max_concurrency)]
+        log_path = os.path.join(directory, "commander.log")
+        with open(log_path, "w") as log:
+            started = time.time()
+            process = subprocess.Popen([sys.executable, COMMANDER] + arguments, cwd=directory, stdout=log,
+                                       stderr=subprocess.STDOUT)
+            _, status, usage = os.wait4(process.pid, 0)
+            wall = time.time() - started
+        if status != 0 or config.keep_log:
+            with open(log_path) as log:
+                tail = log.readlines()[-20:]
+            print(f"Commander exited with status {status}, last lines of its log:\n" + "".join(tail))
+    cluster.stop()
+
+    nodes = cluster.nodes
+    first = min((node.first_request for node in nodes if node.first_request), default=started)
+    last = max((node.last_output for node in nodes if node.last_output), default=time.time())
+    makespan = max(last - first, 1e-9)
+    outputs = sum(node.outputs for node in nodes)
+    tasks = tasks if tasks is not None else outputs
+    busy = sum(node.compute_seconds for node in nodes)
+    cpu = usage.ru_utime + usage.ru_stime
+    return {"workload": name, "nodes": len(nodes), "tasks": tasks, "outputs": outputs, "wall": wall,
+            "makespan": makespan, "tasks_per_sec": tasks / makespan, "commander_cpu": cpu,
+            "commander_cpu_percent": 100.0 * cpu / wall, "node_idle_fraction": 1.0 - busy / (makespan * len(nodes)),
+            "failures": sum(node.failures for node in nodes), "reboots": sum(node.reboots for node in nodes),
+            "exit_status": status}
+
+def median_result(runs):
+    result = dict(runs[0])
+    for key, value in runs[0].items():
+        if isinstance(value, (int, float)) and key not in ("nodes", "tasks", "exit_status"):
+            result[key] = statistics.median(run[key] for run in runs)
+    result["exit_status"] = max(run["exit_status"] for run in runs)
+    result["runs"] = len(runs)
+    return result
+
+def report(results, baseline=None, tolerance=0.1):
+    """Print the results and, given a baseline, whether throughput regressed. Returns False on a regression."""
+    print(f"{'workload':<10} {'nodes':>5} {'tasks':>6} {'makespan s':>10} {'tasks/s':>9} {'cpu s':>7} {'cpu %':>6} "
+          f"{'idle %':>7} {'fails':>5} {'reboots':>7}")
+    ok = True
+    for result in results:
+        line = (f"{result['workload']:<10} {result['nodes']:>5} {result['tasks']:>6} {result['makespan']:>10.2f} "
+                f"{result['tasks_per_sec']:>9.2f} {result['commander_cpu']:>7.2f} {result['commander_cpu_percent']:>6.1f} "
+                f"{100 * result['node_idle_fraction']:>7.1f} {result['failures']:>5} {result['reboots']:>7}")
+        previous = (baseline or {}).get(result["workload"])
+        if previous:
+            change = result["tasks_per_sec"] / previous["tasks_per_sec"] - 1.0
+            line += f"  {100 * change:+.1f}% vs baseline"
+            if change < -tolerance:
+                line += " REGRESSION"
+                ok = False
+        print(line)
+    return ok
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="""
+Run tessie.py against a simulated cluster and report throughput, makespan,
+commander CPU use and node idle time. Needs root (nodes listen on port 80).
+
+Workloads: """ + ", ".join(f"{name} ({spec['help']})" for name, spec in WORKLOADS.items()) + """
+
+Examples:
+   python3 cluster_bench.py --nodes 300 --workloads sweep tiny --output bench.json
+   python3 cluster_bench.py --nodes 300 --workloads sweep tiny --baseline bench.json
+   python3 cluster_bench.py --nodes 500 --workloads sweep --failure-rate 0.01 --reboot-rate 0.002
+""", formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("--nodes", type=int, default=100, help="Number of simulated nodes (default 100).")
+    parser.add_argument("--workloads", nargs="+", default=list(WORKLOADS), choices=list(WORKLOADS),
+                        help="Workloads to run (default all).")
+    parser.add_argument("--tasks", type=int, help="Tasks of the sweep and tiny workloads (default 1000 and 5000).")
+    parser.add_argument("--compute", type=float, help="Seconds a task computes on a node of average speed.")
+    parser.add_argument("--compute-per-kb", type=float, help="Extra compute seconds per KB of payload.")
+    parser.add_argument("--jitter", type=float, default=0.2, help="Log-normal sigma of the compute time (default 0.2).")
+    parser.add_argument("--spread", type=float, default=0.3,
+                        help="Nodes differ in speed and bandwidth by up to this fraction (default 0.3).")
+    parser.add_argument("--bandwidth", type=parse_size, default="100k",
+                        help="Node bandwidth in bytes per second, k and M suffixes allowed (default 100k).")
+    parser.add_argument("--latency", type=float, default=0.005, help="Seconds added to every request (default 0.005).")
+    parser.add_argument("--failure-rate", type=float, default=0.0,
+                        help="Probability that a request is dropped (default 0).")
+    parser.add_argument("--reboot-rate", type=float, default=0.0,
+                        help="Probability that a node reboots while running a task (default 0).")
+    parser.add_argument("--reboot-seconds", type=float, default=10.0, help="Time a rebooting node is gone (default 10).")
+    parser.add_argument("--beacon-interval", type=float, default=5.0, help="Seconds between beacons of a node (default 5).")
+    parser.add_argument("--binary-bytes", type=parse_size, default="16k", help="Size of the task binary (default 16k).")
+    parser.add_argument("--output-bytes", type=int, default=64, help="Size of each task output (default 64).")
+    parser.add_argument("--shard-mb", type=int, help="Size of the sharded workload's input (default 32).")
+    parser.add_argument("--max-concurrency", type=int, help="Passed on to tessie.py.")
+    parser.add_argument("--repeat", type=int, default=1, help="Runs per workload, the median is reported (default 1).")
+    parser.add_argument("--seed", type=int, default=1911, help="Seed of the cluster and the injected faults (default 1911).")
+    parser.add_argument("--output", help="Write the results as JSON to this file.")
+    parser.add_argument("--baseline", help="Compare tasks/s with the results of an earlier --output.")
+    parser.add_argument("--tolerance", type=float, default=0.1,
+                        help="Slowdown against the baseline reported as a regression (default 0.1).")
+    parser.add_argument("--keep-log", action="store_true", help="Print the tail of the commander's log after each run.")
+    args = parser.parse_args()
+
+    results = []
+    for name in args.workloads:
+        config = argparse.Namespace(**vars(args))
+        for key, value in WORKLOADS[name].items():
+            if key != "help" and getattr(config, key, None) is None:
+                setattr(config, key, value)
+        for key in ("tasks", "compute", "compute_per_kb", "shard_mb"):
+            if getattr(config, key) is None:
+                setattr(config, key, 0)
+        print(f"Running {name} on {args.nodes} simulated nodes...")
+        results.append(median_result([run_once(name, config) for _ in range(args.repeat)]))
+
+    baseline = None
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = {result["workload"]: result for result in json.load(f)}
+    ok = report(results, baseline, args.tolerance)
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(results, f, indent=2)
+    sys.exit(0 if ok and all(result["exit_status"] == 0 for result in results) else 1)
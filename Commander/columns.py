@@ -0,0 +1,156 @@
+# Tesselator commander - columnar container
+# https://github.com/invpe/Tesselator
+#
+# Datasets travel to the nodes as text and tasks spend much of their time parsing it. A columnar
+# file holds the same table as typed binary columns a task reads straight into arrays, see
+# Tasks/tessie_columns.h. All integers are little-endian, like every node:
+#
+#   header     "TSCL", uint16 version, uint16 column count, uint32 row count, uint32 reserved
+#   per column char name[24] (NUL padded), uint8 type, uint8 element size, uint16 reserved,
+#              uint32 offset of the column data from the start of the file
+#   data       every column's rows x elements, each column starting at a multiple of 8
+#
+# The type is the struct format character of the elements: "i" int32, "q" int64, "f" float32
+# or "d" float64.
+import array
+import csv
+import struct
+import sys
+
+MAGIC = b"TSCL"
+VERSION = 1
+HEADER = struct.Struct("<4sHHII")
+NAME_SIZE = 24  # Bytes of a column name, the last one stays NUL
+MAX_COLUMNS = 16  # Most columns a task opens, TESSIE_COLUMNS_MAX of Tasks/tessie_columns.h
+COLUMN = struct.Struct(f"<{NAME_SIZE}sBBHI")
+ALIGN = 8
+TYPES = {"i": 4, "q": 8, "f": 4, "d": 8}
+INT32_RANGE = (-2 ** 31, 2 ** 31 - 1)
+
+def align(offset):
+    return (offset + ALIGN - 1) // ALIGN * ALIGN
+
+def parse_number(text):
+    """int for integer fields, float for the others; ValueError if the field is not a number."""
+    text = text.strip()
+    try:
+        return int(text)
+    except ValueError:
+        return float(text)
+
+def infer_type(values):
+    """int32 for integers within its range, int64 for larger integers, float64 otherwise."""
+    if all(isinstance(v, int) for v in values) and (not values or INT32_RANGE[0] <= min(values) and max(values) <= INT32_RANGE[1]):
+        return "i"
+    if all(isinstance(v, int) for v in values):
+        return "q"
+    return "d"
+
+def read_csv(csv_path):
+    """Names and value lists of a CSV file, numbered col0, col1, ... when it has no header row."""
+    with open(csv_path, "r", newline="") as f:
+        rows = [row for row in csv.reader(f) if row and any(field.strip() for field in row)]
+    names = None
+    if rows:
+        try:
+            [parse_number(field) for field in rows[0]]
+        except ValueError:
+            names = [field.strip() for field in rows[0]]
+            rows = rows[1:]
+    width = len(names) if names else max((len(row) for row in rows), default=0)
+    if names is None:
+        names = [f"col{i}" for i in range(width)]
+    columns = [[] for _ in range(width)]
+    for line, row in enumerate(rows, 1):
+        if len(row) != width:
+            raise ValueError(f"row {line} of {csv_path} has {len(row)} fields, expected {width}")
+        for column, field in zip(columns, row):
+            column.append(parse_number(field))
+    return names, columns
+
+def write_columns(path, names, columns, types=None):
+    """Write value lists as a columnar file, returns its size in bytes.
+
+    `types` gives one type character per column, missing ones are inferred from the values.
+    """
+    types = list(types or [])
+    types += [infer_type(values) for values in columns[len(types):]]
+    rows = len(columns[0]) if columns else 0
+    if len(columns) > MAX_COLUMNS:
+        raise ValueError(f"{len(columns)} columns, a task reads at most {MAX_COLUMNS}")
+    for name, values, kind in zip(names, columns, types):
+        if kind not in TYPES:
+            raise ValueError(f"unknown column type {kind!r} of {name}, expected one of {''.join(TYPES)}")
+        if len(name.encode()) >= NAME_SIZE:
+            raise ValueError(f"column name {name!r} is longer than {NAME_SIZE - 1} bytes")
+        if len(values) != rows:
+            raise ValueError(f"column {name} has {len(values)} rows, expected {rows}")
+
+    offset = align(HEADER.size + COLUMN.size * len(columns))
+    descriptors = bytearray(HEADER.pack(MAGIC, VERSION, len(columns), rows, 0))
+    blocks = []
+    for name, values, kind in zip(names, columns, types):
+        data = array.array(kind, [float(v) for v in values] if kind in "fd" else values)
+        if sys.byteorder != "little":
+            data.byteswap()
+        descriptors += COLUMN.pack(name.encode(), ord(kind), TYPES[kind], 0, offset)
+        blocks.append((offset, data.tobytes()))
+        offset = align(offset + len(blocks[-1][1]))
+
+    with open(path, "wb") as f:
+        f.write(descriptors)
+        for start, data in blocks:
+            f.write(b"\0" * (start - f.tell()))
+            f.write(data)
+        f.write(b"\0" * (offset - f.tell()))
+        return f.tell()
+
+def read_columns(path):
+    """Names, type characters and value arrays of a columnar file."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < HEADER.size:
+        raise ValueError(f"{path} is not a columnar file")
+    magic, version, count, rows, _ = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError(f"{path} is not a columnar file of version {VERSION}")
+    names, types, columns = [], [], []
+    for i in range(count):
+        name, kind, size, _, offset = COLUMN.unpack_from(data, HEADER.size + COLUMN.size * i)
+        kind = chr(kind)
+        if TYPES.get(kind) != size or offset + rows * size > len(data):
+            raise ValueError(f"column {i} of {path} is damaged")
+        values = array.array(kind, data[offset:offset + rows * size])
+        if sys.byteorder != "little":
+            values.byteswap()
+        names.append(name.rstrip(b"\0").decode(errors="replace"))
+        types.append(kind)
+        columns.append(values)
+    return names, types, columns
+
+def format_value(value, kind):
+    if kind in "iq":
+        return str(value)
+    if kind == "f":
+        # Shortest text that reads back to the same float32
+        for digits in range(6, 10):
+            text = "%.*g" % (digits, value)
+            if struct.unpack("<f", struct.pack("<f", float(text)))[0] == value:
+                return text
+    return repr(value)
+
+def csv_to_columns(csv_path, path, types=None):
+    """Convert a CSV file to a columnar file, returns (rows, columns, bytes written)."""
+    names, columns = read_csv(csv_path)
+    size = write_columns(path, names, columns, types)
+    return (len(columns[0]) if columns else 0), len(columns), size
+
+def columns_to_csv(path, csv_path):
+    """Convert a columnar file (e.g. a task output) to CSV with a header row, returns (rows, columns)."""
+    names, types, columns = read_columns(path)
+    with open(csv_path, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(names)
+        for row in zip(*columns):
+            writer.writerow([format_value(v, kind) for v, kind in zip(row, types)])
+    return (len(columns[0]) if columns else 0), len(columns)
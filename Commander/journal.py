@@ -0,0 +1,97 @@
+# Tesselator commander - job journal
+# https://github.com/invpe/Tesselator
+#
+# Append-only log of a job, one JSON record per line, flushed to disk before the
+# commander moves on. Replaying it after a crash tells which tasks completed (and
+# where their outputs are), and which node each unfinished task was last sent to.
+#
+#   {"type": "job",      "binary_sha256": ...}
+#   {"type": "task",     "id": ..., "definition": {...}}
+#   {"type": "assign",   "id": ..., "node": ip, "total_executed": n}
+#   {"type": "complete", "id": ..., "node": ip, "output": path, "items": {position: path}}
+#   {"type": "fail",     "id": ..., "node": ip}
+import json
+import os
+import threading
+import time
+
+class Journal:
+    def __init__(self, path):
+        self.path = path
+        self.lock = threading.Lock()
+        self.binary_sha256 = None
+        self.definitions = {}  # id -> task definition
+        self.assignments = {}  # id -> last assign record of a task that hasn't completed
+        self.completed = {}    # id -> complete record
+        if os.path.exists(path):
+            self.replay()
+        self.file = open(path, "a")
+
+    def replay(self):
+        intact = 0  # Bytes up to the end of the last complete record
+        with open(self.path, "rb") as f:
+            for line in f:
+                try:
+                    if not line.endswith(b"\n"):
+                        raise ValueError("record without its newline")
+                    record = json.loads(line)
+                except ValueError:
+                    continue  # A record torn by the crash, everything before it is intact
+                intact = f.tell()
+                kind = record.get("type")
+                if kind == "job":
+                    self.binary_sha256 = record["binary_sha256"]
+                elif kind == "task":
+                    self.definitions[record["id"]] = record["definition"]
+                elif kind == "assign":
+                    self.assignments[record["id"]] = record
+                elif kind == "complete":
+                    self.completed[record["id"]] = record
+                    self.assignments.pop(record["id"], None)
+                elif kind == "fail":
+                    self.assignments.pop(record["id"], None)
+
+        # Cut off a torn record, or the next one would be appended to it and lost on the next replay
+        if os.path.getsize(self.path) > intact:
+            with open(self.path, "r+b") as f:
+                f.truncate(intact)
+
+    def append(self, record):
+        record["time"] = time.time()
+        with self.lock:
+            self.file.write(json.dumps(record) + "\n")
+            self.file.flush()
+            os.fsync(self.file.fileno())
+
+    def start(self, binary_sha256):
+        """Record the job's binary, returns False if the journal belongs to a different binary."""
+        if self.binary_sha256 is None:
+            self.binary_sha256 = binary_sha256
+            self.append({"type": "job", "binary_sha256": binary_sha256})
+        return self.binary_sha256 == binary_sha256
+
+    def define(self, task_id, definition):
+        if task_id in self.definitions:
+            return
+        self.definitions[task_id] = definition
+        self.append({"type": "task", "id": task_id, "definition": definition})
+
+    def assign(self, task_id, node, total_executed):
+        record = {"type": "assign", "id": task_id, "node": node, "total_executed": total_executed}
+        self.assignments[task_id] = record
+        self.append(record)
+
+    def complete(self, task_id, node, output, items=None):
+        record = {"type": "complete", "id": task_id, "node": node, "output": output}
+        if items is not None:
+            record["items"] = {str(position): path for position, path in items.items()}
+        self.completed[task_id] = record
+        self.assignments.pop(task_id, None)
+        self.append(record)
+
+    def fail(self, task_id, node):
+        self.assignments.pop(task_id, None)
+        self.append({"type": "fail", "id": task_id, "node": node})
+
+    def close(self):
+        self.file.close()
@@ -0,0 +1,94 @@
+# Tesselator commander - node performance profiles
+# https://github.com/invpe/Tesselator
+#
+# A profile is what `tessie.py --bench` measured on one node: the rate of every benchmark of
+# Tasks/tessie_bench.c, the loader overhead and the upload bandwidth. Profiles are kept per MAC
+# address, so they follow a node across address changes, with the runs of earlier benchmarks
+# to tell a node that got slower from one that always was slow.
+import json
+import math
+import os
+import statistics
+import threading
+import time
+
+HISTORY = 20  # Benchmark runs kept per node
+DEGRADED_RATIO = 0.8  # A rate below this share of the reference is reported as degraded
+
+# Benchmark name -> (unit shown, scale from the stored rate, higher is better)
+METRICS = {
+    "int32": ("Mops/s", 1e-6, True),
+    "float": ("MFLOPS", 1e-6, True),
+    "double": ("MFLOPS", 1e-6, True),
+    "memory": ("MB/s", 1e-6, True),
+    "spiffs_w": ("KB/s", 1e-3, True),
+    "spiffs_r": ("KB/s", 1e-3, True),
+    "stdio": ("lines/s", 1, True),
+    "load": ("ms", 1e3, False),
+    "upload": ("KB/s", 1e-3, True),
+}
+
+# Benchmarks of plain computation, their geometric mean ranks the nodes for the scheduler
+COMPUTE = ("int32", "float", "double", "memory")
+
+def speed_index(rates):
+    """Geometric mean of the compute rates of a profile, None if one is missing."""
+    values = [rates.get(name) for name in COMPUTE]
+    if any(not value for value in values):
+        return None
+    return math.exp(sum(math.log(value) for value in values) / len(values))
+
+def compare(rates, reference):
+    """Benchmarks where `rates` fall below DEGRADED_RATIO of `reference`, as {name: share of the reference}."""
+    degraded = {}
+    for name, rate in rates.items():
+        base = reference.get(name)
+        if not rate or not base or name not in METRICS:
+            continue
+        share = rate / base if METRICS[name][2] else base / rate
+        if share < DEGRADED_RATIO:
+            degraded[name] = share
+    return degraded
+
+def median_rates(profiles):
+    """Per benchmark median over several profiles' rates."""
+    names = {name for profile in profiles for name in profile}
+    return {name: statistics.median(p[name] for p in profiles if p.get(name)) for name in names
+            if any(p.get(name) for p in profiles)}
+
+class ProfileStore:
+    def __init__(self, directory):
+        self.directory = directory
+        self.lock = threading.Lock()
+
+    def path(self, mac):
+        return os.path.join(self.directory, mac.replace(":", "").lower() + ".json")
+
+    def runs(self, mac):
+        """Earlier benchmark runs of a node, oldest first."""
+        try:
+            with open(self.path(mac)) as f:
+                return json.load(f).get("runs", [])
+        except (OSError, ValueError):
+            return []
+
+    def latest(self, mac):
+        runs = self.runs(mac)
+        return runs[-1] if runs else None
+
+    def add(self, mac, node, arch, rates):
+        """Record a benchmark run of a node, returns the run as stored."""
+        run = {"time": time.time(), "node": node, "arch": arch, "rates": rates}
+        with self.lock:
+            runs = (self.runs(mac) + [run])[-HISTORY:]
+            os.makedirs(self.directory, exist_ok=True)
+            temporary = self.path(mac) + ".tmp"
+            with open(temporary, "w") as f:
+                json.dump({"mac": mac, "runs": runs}, f, indent=1)
+            os.replace(temporary, self.path(mac))
+        return run
+
+    def history_median(self, mac):
+        """Median rates of the runs before the latest one, None without earlier runs."""
+        runs = self.runs(mac)[:-1]
+        return median_rates([run["rates"] for run in runs]) if runs else None
@@ -0,0 +1,177 @@
+# Tesselator commander - reduce stage
+# https://github.com/invpe/Tesselator
+#
+# Reducers combine task outputs as they arrive, so the final answer is ready the moment
+# the last task completes. A reducer is any object with two methods:
+#
+#   add(index, path)  - consume the output file of the task queued at position `index`
+#   result()          - return the combined result as text
+#
+# Reducers are selected with a spec "name[:param]", e.g. "sum", "topk:10", "hist:# Bin".
+# A spec naming a .py file loads a plugin instead: the file defines `class Reducer`,
+# constructed with the optional param, e.g. "my_reducer.py:param".
+import heapq
+import importlib.util
+import os
+import re
+import threading
+
+NUMBER = re.compile(r"[-+]?(?:\d+\.?\d*|\.\d+)(?:[eE][-+]?\d+)?")
+KEY_VALUE = re.compile(r"^(.*\S)\s*[:=]\s*([-+]?(?:\d+\.?\d*|\.\d+)(?:[eE][-+]?\d+)?)\s*$")
+
+def last_number(line):
+    """Return the last number on a line, or None if there is none."""
+    numbers = NUMBER.findall(line)
+    return float(numbers[-1]) if numbers else None
+
+def read_lines(path):
+    with open(path, "r", errors="replace") as f:
+        for line in f:
+            yield line.rstrip("\r\n")
+
+def format_number(value):
+    return str(int(value)) if value == int(value) else repr(value)
+
+class NumericReducer:
+    """Sum, min or max of the last number on every output line (e.g. partial sums from tessie_mpi)."""
+    def __init__(self, operation):
+        self.operation = operation
+        self.value = None
+        self.count = 0
+
+    def add(self, index, path):
+        for line in read_lines(path):
+            number = last_number(line)
+            if number is None:
+                continue
+            self.count += 1
+            if self.value is None:
+                self.value = number
+            elif self.operation == "sum":
+                self.value += number
+            elif self.operation == "min":
+                self.value = min(self.value, number)
+            else:
+                self.value = max(self.value, number)
+
+    def result(self):
+        if self.value is None:
+            return "No numeric values found"
+        return f"{self.operation} = {self.value!r} over {self.count} values"
+
+class HistogramReducer:
+    """Sum `key = value` and `key: value` lines by key (e.g. the `# Bin (x, y)` lines of tessie_chaos).
+
+    The optional param restricts merging to keys starting with it, other lines are skipped.
+    """
+    def __init__(self, prefix=None):
+        self.prefix = prefix
+        self.bins = {}  # Keeps first-seen key order
+
+    def add(self, index, path):
+        for line in read_lines(path):
+            match = KEY_VALUE.match(line)
+            if not match:
+                continue
+            key = match.group(1)
+            if self.prefix and not key.startswith(self.prefix):
+                continue
+            self.bins[key] = self.bins.get(key, 0) + float(match.group(2))
+
+    def result(self):
+        return "\n".join(f"{key} = {format_number(value)}" for key, value in self.bins.items())
+
+class ConcatReducer:
+    """Concatenate outputs in queue order into one file.
+
+    Outputs are appended as soon as all earlier ones are in, so only the paths of
+    outputs that arrived out of order are held back, never their content.
+    """
+    def __init__(self, output_path=None):
+        self.output_path = output_path or "reduced_output.txt"
+        self.next_index = 0
+        self.pending = {}  # index -> path, waiting for earlier outputs
+        open(self.output_path, "wb").close()
+
+    def add(self, index, path):
+        self.pending[index] = path
+        with open(self.output_path, "ab") as out:
+            while self.next_index in self.pending:
+                with open(self.pending.pop(self.next_index), "rb") as f:
+                    while True:
+                        chunk = f.read(65536)
+                        if not chunk:
+                            break
+                        out.write(chunk)
+                self.next_index += 1
+
+    def skip(self, index):
+        """Mark a task that produced no output so later outputs aren't held back."""
+        self.add(index, os.devnull)
+
+    def result(self):
+        missing = f", {len(self.pending)} outputs waiting for earlier ones" if self.pending else ""
+        return f"Concatenated {self.next_index} outputs into {self.output_path}{missing}"
+
+class TopKReducer:
+    """Keep the k output lines with the largest last number."""
+    def __init__(self, k=None):
+        self.k = int(k) if k else 10
+        self.heap = []  # (value, sequence, line), smallest on top
+        self.sequence = 0
+
+    def add(self, index, path):
+        for line in read_lines(path):
+            number = last_number(line)
+            if number is None:
+                continue
+            self.sequence += 1
+            entry = (number, self.sequence, line)
+            if len(self.heap) < self.k:
+                heapq.heappush(self.heap, entry)
+            elif entry > self.heap[0]:
+                heapq.heapreplace(self.heap, entry)
+
+    def result(self):
+        return "\n".join(line for _, _, line in sorted(self.heap, reverse=True))
+
+def load_plugin(path, param):
+    spec = importlib.util.spec_from_file_location(os.path.splitext(os.path.basename(path))[0], path)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    if not hasattr(module, "Reducer"):
+        raise ValueError(f"Reducer plugin {path} does not define class Reducer")
+    return module.Reducer(param) if param is not None else module.Reducer()
+
+def make_reducer(spec):
+    """Build a reducer from a "name[:param]" spec."""
+    name, _, param = spec.partition(":")
+    param = param or None
+    if name in ("sum", "min", "max"):
+        return NumericReducer(name)
+    if name == "hist":
+        return HistogramReducer(param)
+    if name == "concat":
+        return ConcatReducer(param)
+    if name == "topk":
+        return TopKReducer(param)
+    if name.endswith(".py"):
+        return load_plugin(name, param)
+    raise ValueError(f"Unknown reducer {name}, use sum, min, max, hist, concat, topk or a .py plugin")
+
+class ReduceStage:
+    """Feeds task outputs to a reducer as they arrive, one at a time."""
+    def __init__(self, reducer):
+        self.reducer = reducer
+        self.lock = threading.Lock()
+
+    def add(self, index, path):
+        with self.lock:
+            if path:
+                self.reducer.add(index, path)
+            elif hasattr(self.reducer, "skip"):
+                self.reducer.skip(index)
+
+    def result(self):
+        with self.lock:
+            return self.reducer.result()
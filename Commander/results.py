@@ -0,0 +1,149 @@
+# Tesselator commander - result store
+# https://github.com/invpe/Tesselator
+#
+# Task outputs are kept as blob files under the store directory, one per result, and
+# indexed in an SQLite database by job, position, task, argument and node:
+#
+#   <dir>/index.sqlite           the index
+#   <dir>/<job>/<n // 1000>/<n>  output of the result at position n of the job
+#   <dir>/<job>/incoming/        outputs being fetched, moved in place once the task completes
+#
+# <job> is the job id with characters unsafe in a file name replaced, followed by a short
+# hash of the id itself, so ids such as "a/b" and "a_b" get directories of their own.
+# A position is the task's index in the job, or the item's index for batched jobs.
+# Queries open their own connection and stream rows, so listing or exporting a job
+# with hundreds of thousands of results never holds them all in memory.
+import csv
+import hashlib
+import io
+import os
+import re
+import sqlite3
+import tarfile
+import tempfile
+import threading
+import time
+import uuid
+
+SCHEMA = """
+CREATE TABLE IF NOT EXISTS results (
+    job      TEXT    NOT NULL,
+    position INTEGER NOT NULL,
+    task     INTEGER,
+    argument TEXT,
+    node     TEXT,
+    path     TEXT    NOT NULL,
+    size     INTEGER NOT NULL,
+    time     REAL    NOT NULL,
+    PRIMARY KEY (job, position)
+);
+CREATE INDEX IF NOT EXISTS results_argument ON results (job, argument);
+CREATE INDEX IF NOT EXISTS results_node ON results (node);
+"""
+COLUMNS = ("job", "position", "task", "argument", "node", "path", "size", "time")
+SAFE_NAME = re.compile(r"[^A-Za-z0-9_.-]")
+
+class ResultStore:
+    def __init__(self, directory):
+        self.directory = directory
+        self.db_path = os.path.join(directory, "index.sqlite")
+        self.lock = threading.Lock()
+        os.makedirs(directory, exist_ok=True)
+        self.db = sqlite3.connect(self.db_path, check_same_thread=False)
+        self.db.execute("PRAGMA journal_mode=WAL")
+        self.db.execute("PRAGMA synchronous=NORMAL")  # Durable against a crash of the tool, cheap per insert
+        self.db.executescript(SCHEMA)
+
+    @staticmethod
+    def job_name(job):
+        """Directory name of a job, distinct for every job id."""
+        return f"{SAFE_NAME.sub('_', job)}-{hashlib.sha256(job.encode()).hexdigest()[:8]}"
+
+    def job_directory(self, job):
+        return os.path.join(self.directory, self.job_name(job))
+
+    def incoming(self, job):
+        """A fresh path to fetch an output to, unique even for copies of the same task."""
+        directory = os.path.join(self.job_directory(job), "incoming")
+        os.makedirs(directory, exist_ok=True)
+        return os.path.join(directory, uuid.uuid4().hex)
+
+    def add(self, job, position, path, task=None, argument=None, node=None):
+        """Move the output at `path` into the store as result `position` of `job`, returns its new path."""
+        relative = os.path.join(self.job_name(job), str(position // 1000), str(position))
+        final = os.path.join(self.directory, relative)
+        os.makedirs(os.path.dirname(final), exist_ok=True)
+        os.replace(path, final)
+        with self.lock:
+            self.db.execute("INSERT OR REPLACE INTO results VALUES (?, ?, ?, ?, ?, ?, ?, ?)",
+                            (job, position, task, argument, node, relative, os.path.getsize(final), time.time()))
+            self.db.commit()
+        return final
+
+    def row(self, values):
+        row = dict(zip(COLUMNS, values))
+        row["path"] = os.path.join(self.directory, row["path"])
+        return row
+
+    def query(self, job, argument=None, node=None):
+        """Results of a job in position order, optionally only those of one argument or node."""
+        sql, params = "SELECT * FROM results WHERE job = ?", [job]
+        if argument is not None:
+            sql, params = sql + " AND argument = ?", params + [argument]
+        if node is not None:
+            sql, params = sql + " AND node = ?", params + [node]
+        db = sqlite3.connect(self.db_path)
+        try:
+            for values in db.execute(sql + " ORDER BY position", params):
+                yield self.row(values)
+        finally:
+            db.close()
+
+    def get(self, job, position):
+        with self.lock:
+            values = self.db.execute("SELECT * FROM results WHERE job = ? AND position = ?", (job, position)).fetchone()
+        return self.row(values) if values else None
+
+    def count(self, job):
+        with self.lock:
+            return self.db.execute("SELECT COUNT(*) FROM results WHERE job = ?", (job,)).fetchone()[0]
+
+    def next_position(self, job):
+        with self.lock:
+            last = self.db.execute("SELECT MAX(position) FROM results WHERE job = ?", (job,)).fetchone()[0]
+        return 0 if last is None else last + 1
+
+    def jobs(self):
+        """(job, results, bytes) of every job in the store."""
+        with self.lock:
+            return self.db.execute("SELECT job, COUNT(*), SUM(size) FROM results GROUP BY job ORDER BY job").fetchall()
+
+    def export(self, job, fileobj):
+        """Stream every result of a job into a tar archive written to `fileobj`, returns the number of results.
+
+        Results are stored as <name>/<position>, followed by <name>/index.tsv with the job,
+        position, task, argument, node and size of each one. <name> is the job's directory
+        name, so an id like "../x" can't place members outside of it; the id itself is only
+        in the index, quoted like the other fields where it holds tabs, quotes or newlines.
+        """
+        name = self.job_name(job)
+        count = 0
+        # The index is spooled to a temporary file, it only goes into the archive after every result
+        with tempfile.TemporaryFile() as index, tarfile.open(fileobj=fileobj, mode="w|") as archive:
+            text = io.TextIOWrapper(index, encoding="utf-8", newline="")
+            writer = csv.writer(text, delimiter="\t", lineterminator="\n")
+            writer.writerow(("job", "position", "task", "argument", "node", "size"))
+            for row in self.query(job):
+                if not os.path.exists(row["path"]):
+                    continue
+                archive.add(row["path"], arcname=f"{name}/{row['position']}")
+                writer.writerow((job, row["position"], row["task"], row["argument"], row["node"], row["size"]))
+                count += 1
+            text.flush()
+            info = tarfile.TarInfo(f"{name}/index.tsv")
+            info.size = index.tell()
+            info.mtime = time.time()
+            index.seek(0)
+            archive.addfile(info, index)
+            text.detach()
+        return count
@@ -2,44 +2,525 @@
 # https://github.com/invpe/Tesselator
 import time
 import socket
+import sys
 import json
 import requests
+import requests.adapters
 import argparse
+import threading
+import http.server
+import urllib.parse
 from collections import deque
 import os
+import struct
+import hashlib
+import math
+import mmap
+import uuid
+import shutil
+import contextlib
+import reducers
+import journal
+import cache
+import results
+import timeline
+import columns
+import profiles
 
 BROADCAST_PORT = 1911  # The port the ESP32 nodes are broadcasting on
 LISTEN_TIMEOUT = 5  # Timeout for listening to new broadcasts (seconds)
 AVAILABLE_NODES = {}  # Dictionary to hold available nodes
-TASK_QUEUE = deque()  # Queue to hold pending tasks
 POLL_INTERVAL = 1  # Polling interval for checking task output (seconds)
+NODE_TIMEOUT = 15  # Seconds without a beacon before a node is considered gone (nodes beacon every 5s)
+NODES_LOCK = threading.Lock()  # Guards AVAILABLE_NODES, updated by the background listener
+CONNECT_TIMEOUT = 5  # Timeout for establishing a connection to a node (seconds)
+REQUEST_TIMEOUT = 30  # Timeout for uploads, arguments and status calls (seconds)
+TASK_TIMEOUT = 600  # How long to wait for a task to finish and return its output (seconds)
+MAX_CONCURRENCY = 64  # Maximum number of tasks in flight at once
+FAILURE_BACKOFF = 10  # Seconds to leave a node alone after a failed submission
+NODE_SESSIONS = {}  # Keep-alive HTTP sessions, one per node
+SESSIONS_LOCK = threading.Lock()
+NODE_MODELS = {}  # Per node NodeModel, learned from completed tasks
+MODELS_LOCK = threading.Lock()
+MODEL_ALPHA = 0.3  # Weight of the newest sample in the rolling node model
+MODEL_MIN_UPLOAD_BYTES = 4096  # Smaller uploads are dominated by latency and don't measure bandwidth
+DEFAULT_UPLOAD_BPS = 100 * 1024  # Assumed upload bandwidth of a node with a perfect signal (bytes per second)
+PLACEMENT_WINDOW = 64  # Number of queued tasks considered when placing a task on a node
+DECLINE_RATIO = 1.5  # A node declines a tail task that would finish this much later than elsewhere
+SPECULATION_FACTOR = 2.0  # Launch a backup copy once a task runs this many times longer than expected
+SPECULATION_MIN_SECONDS = 10  # Never launch a backup copy for a task running less than this
+SHARDS_PER_NODE = 4  # Automatic sharding aims for this many shards per node for load balance
+SHARD_SPIFFS_FRACTION = 0.5  # Largest share of a node's free SPIFFS a shard may take (binary and output need room too)
+DEFAULT_SHARD_BYTES = 256 * 1024  # Shard size limit when no node reported its free SPIFFS
+SHARD_SCAN_BLOCK = 4096  # Read size when looking for line boundaries
+HASH_BLOCK = 1024 * 1024  # Block size when hashing payloads for the result cache
+CACHE_DIR = os.path.expanduser("~/.tessie_cache")  # Default location of the result cache
+CACHE_MAX_MB = 1024  # Default size limit of the result cache (megabytes)
+JOURNAL_DIR = "tessie_jobs"  # Where job journals are kept, one per job id
+RESULTS_DIR = "tessie_results"  # Default location of the result store
+BATCH_MAGIC = b"TSBT"  # Marks a payload packed from many work items, see Tasks/tessie_batch.h
+RANGE_FORMAT = "{start}:{end}"  # Argument generated for every chunk of a range
+RANGE_GSS_DIVISOR = 2  # A chunk is remaining / (RANGE_GSS_DIVISOR * nodes), scaled by node speed
+DAEMON_HOST = "127.0.0.1"  # The daemon's job API only listens locally
+DAEMON_PORT = 1912  # Port of the daemon's job API
+CLOCK_SYNC_SAMPLES = 5  # /clock round trips per sync, the one with the shortest round trip sets the offset
+CLOCK_SYNC_INTERVAL = 60  # Seconds before a node's clock offset is measured again, to follow drift
+ELF_MACHINES = {94: "xtensa", 62: "x86_64", 243: "riscv"}  # ELF e_machine of a build -> node architecture
+DEFAULT_ARCH = "xtensa"  # Architecture of nodes whose beacon does not name one
+PROFILES_DIR = "tessie_profiles"  # Default location of the node performance profiles, one per MAC address
+PROFILE_STORE = None  # ProfileStore the scheduler seeds node models from, set at startup
+BENCH_REPEAT = 3  # Runs of every benchmark, the fastest one counts
+BENCH_MIN_SECONDS = 0.5  # Benchmarks are scaled up until a run takes at least this long
+BENCH_MAX_COUNT = 10 ** 9  # Largest iteration count a benchmark is scaled to
+BENCH_PAYLOAD_BYTES = 64 * 1024  # Payload uploaded for the SPIFFS read benchmark, also measures the upload
+# Benchmarks of Tasks/tessie_bench.c: name, first iteration count, work per iteration (operations, bytes or lines)
+BENCHMARKS = [
+    ("empty", 0, 0),
+    ("int32", 100000, 4),
+    ("float", 10000, 16),
+    ("double", 10000, 16),
+    ("memory", 100, 8192),
+    ("spiffs_w", 16, 1024),
+    ("spiffs_r", 1, BENCH_PAYLOAD_BYTES),
+    ("stdio", 100, 1),
+]
 
 class Task:
-    def __init__(self, binary_data, payload_files=None, argument=None):
+    def __init__(self, binary_data, payload_files=None, argument=None, work=None):
         self.binary_data = binary_data
 
-        # Optional payload files (can be None)
+        # Optional payload files or shards of a file (can be None), referenced and read only on upload
         self.payloads = {}
         if payload_files:
             for payload_file in payload_files:
-                file_content = self.read_file(payload_file)
-                self.payloads[payload_file] = file_content
+                if not isinstance(payload_file, (Payload, BytesPayload)):
+                    payload_file = Payload.from_file(payload_file)
+                self.payloads[payload_file.name] = payload_file
 
         # Optional argument (can be None or empty string)
         self.argument = argument
 
-    def read_file(self, file_path):
-        """Utility to read and return file content in binary mode."""
-        if os.path.isfile(file_path):
-            with open(file_path, 'rb') as f:
-                return f.read()
-        raise ValueError(f"File {file_path} not found!")
+        # Relative amount of computation, used by the scheduler to compare tasks
+        self.work = work if work is not None else max(self.payload_bytes, 1)
+
+        # Position in the job, used to keep ordered reductions in queue order
+        self.index = None
+
+        # Hash of the binary, set per job, and the task's key in the result cache, computed on first use
+        self.binary_hash = None
+        self.cache_key = None
+
+        # For batched tasks, the job positions of the items packed into the payload and their arguments
+        self.batch = None
+        self.items = None
+
+        # For tasks generated from a range, the (start, end) they cover
+        self.range = None
+
+        # The job the task belongs to, set when it is queued, and when the task was created
+        self.job = None
+        self.created = time.time()
+
+        # Speculative execution state: copies currently running and whether one finished
+        self.copies = 0
+        self.done = False
+
+    def describe(self):
+        """Definition of the task as recorded in the job journal."""
+        definition = {"argument": self.argument, "payloads": sorted(self.payloads), "work": self.work}
+        if self.batch is not None:
+            definition["batch"] = self.batch
+        if self.range is not None:
+            definition["range"] = list(self.range)
+        return definition
+
+    @property
+    def payload_bytes(self):
+        return sum(payload.length for payload in self.payloads.values())
 
     def __repr__(self):
         return f"<Task with {len(self.payloads)} payloads and argument: {self.argument}>"
 
-def listen_for_nodes():
-    """Listen for node advertisements and update the available nodes list."""
+class Payload:
+    """A byte range of a file, never held in memory: it is uploaded and hashed from a memory map."""
+    def __init__(self, path, offset=0, length=None, name=None):
+        self.path = path
+        self.offset = offset
+        self.length = os.path.getsize(path) - offset if length is None else length
+        self.name = name or path
+
+    @classmethod
+    def from_file(cls, file_path):
+        if not os.path.isfile(file_path):
+            raise ValueError(f"File {file_path} not found!")
+        return cls(file_path)
+
+    @contextlib.contextmanager
+    def view(self):
+        """Memory view of the payload bytes, valid inside the `with` block."""
+        if self.length == 0:
+            yield memoryview(b"")
+            return
+        with open(self.path, "rb") as f, mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as mapped:
+            view = memoryview(mapped)[self.offset:self.offset + self.length]
+            try:
+                yield view
+            finally:
+                view.release()
+
+    def sha256(self):
+        h = hashlib.sha256()
+        with self.view() as view:
+            for start in range(0, len(view), HASH_BLOCK):
+                h.update(view[start:start + HASH_BLOCK])
+        return h.digest()
+
+    def __repr__(self):
+        return f"<Payload {self.name} at {self.offset}+{self.length}>"
+
+class BytesPayload:
+    """A payload generated in memory, e.g. a packed batch."""
+    def __init__(self, name, data):
+        self.name = name
+        self.data = data
+        self.length = len(data)
+
+    @contextlib.contextmanager
+    def view(self):
+        yield memoryview(self.data)
+
+    def sha256(self):
+        return hashlib.sha256(self.data).digest()
+
+class Shard(Payload):
+    """A record-aligned byte range of a larger input file, sent to a node as its payload."""
+    def __init__(self, path, index, offset, length, work):
+        super().__init__(path, offset, length, f"{os.path.basename(path)}.{index}")
+        self.work = work  # Bytes this shard owns, excluding the overlap with the previous shard
+
+class MultipartBody:
+    """multipart/form-data upload of one file, read in blocks straight from the payload view.
+
+    Has a length, so requests sends a Content-Length and streams the body without
+    building it in memory (nodes don't support chunked uploads).
+    """
+    def __init__(self, view, filename):
+        boundary = uuid.uuid4().hex
+        self.content_type = f"multipart/form-data; boundary={boundary}"
+        head = (f"--{boundary}\r\nContent-Disposition: form-data; name=\"file\"; filename=\"{filename}\"\r\n"
+                f"Content-Type: application/octet-stream\r\n\r\n").encode()
+        tail = f"\r\n--{boundary}--\r\n".encode()
+        self.parts = [memoryview(head), view, memoryview(tail)]
+        self.total = sum(len(part) for part in self.parts)
+        self.part = 0
+        self.position = 0
+
+    def __len__(self):
+        return self.total
+
+    def read(self, size=-1):
+        if size is None or size < 0:
+            size = self.total
+        chunks = []
+        while size > 0 and self.part < len(self.parts):
+            current = self.parts[self.part]
+            chunk = current[self.position:self.position + size]
+            chunks.append(bytes(chunk))
+            size -= len(chunk)
+            self.position += len(chunk)
+            if self.position >= len(current):
+                self.part += 1
+                self.position = 0
+        return b"".join(chunks)
+
+def next_line_start(f, offset, file_size):
+    """Return the offset of the first line starting at or after `offset`."""
+    if offset <= 0:
+        return 0
+    f.seek(offset - 1)
+    while True:
+        block = f.read(SHARD_SCAN_BLOCK)
+        if not block:
+            return file_size
+        newline = block.find(b"\n")
+        if newline >= 0:
+            return f.tell() - len(block) + newline + 1
+
+def previous_lines_start(f, offset, lines):
+    """Return the offset where the `lines` lines preceding `offset` begin."""
+    position = offset
+    remaining = lines + 1  # The newline ending the previous line doesn't count
+    while position > 0 and remaining > 0:
+        start = max(position - SHARD_SCAN_BLOCK, 0)
+        f.seek(start)
+        block = f.read(position - start)
+        for i in range(len(block) - 1, -1, -1):
+            if block[i] == 0x0A:
+                remaining -= 1
+                if remaining == 0:
+                    return start + i + 1
+        position = start
+    return 0
+
+def shard_file(path, shard_count, record_size=0, overlap=0):
+    """Split `path` into `shard_count` record-aligned shards.
+
+    Records are lines when `record_size` is 0, fixed `record_size` byte blocks otherwise.
+    Every shard but the first also carries the `overlap` records preceding it, for tasks
+    that need a window of history (tessie_chaos needs 3).
+    """
+    file_size = os.path.getsize(path)
+    shard_count = max(min(shard_count, file_size), 1)
+    shards = []
+    with open(path, "rb") as f:
+        # Record-aligned boundaries between the shards
+        boundaries = [0]
+        for i in range(1, shard_count):
+            target = file_size * i // shard_count
+            if record_size:
+                boundary = target - target % record_size
+            else:
+                boundary = next_line_start(f, target, file_size)
+            if boundary > boundaries[-1]:
+                boundaries.append(boundary)
+        boundaries.append(file_size)
+
+        for index in range(len(boundaries) - 1):
+            start, end = boundaries[index], boundaries[index + 1]
+            if record_size:
+                with_overlap = max(start - overlap * record_size, 0)
+            else:
+                with_overlap = previous_lines_start(f, start, overlap) if overlap else start
+            shards.append(Shard(path, index, with_overlap, end - with_overlap, end - start))
+    return shards
+
+def plan_shard_count(file_size, live_nodes):
+    """Choose a shard count that fits every node's free SPIFFS and gives each node several shards."""
+    free_spiffs = [info["free_spiffs_bytes"] for info in live_nodes.values() if isinstance(info["free_spiffs_bytes"], int)]
+    max_shard_bytes = int(min(free_spiffs) * SHARD_SPIFFS_FRACTION) if free_spiffs else DEFAULT_SHARD_BYTES
+    by_capacity = -(-file_size // max(max_shard_bytes, 1))
+    return max(by_capacity, len(live_nodes) * SHARDS_PER_NODE, 1)
+
+def build_batch_payload(items):
+    """Pack work items into one payload: "TSBT", count, (offset, length) per item, item data.
+
+    The layout is read by Tasks/tessie_batch.h, all integers are little-endian uint32.
+    """
+    encoded = [item.encode() if isinstance(item, str) else item for item in items]
+    index = bytearray(BATCH_MAGIC + struct.pack("<I", len(encoded)))
+    offset = 0
+    for data in encoded:
+        index += struct.pack("<II", offset, len(data))
+        offset += len(data)
+    return bytes(index) + b"".join(encoded)
+
+def split_batch_output(output_path, batch):
+    """Split a batched output into one file per item, returns {job position: path or None}.
+
+    Each result in the output is a uint32 item index and uint32 length followed by the data.
+    """
+    results = {position: None for position in batch}
+    with open(output_path, "rb") as f:
+        while True:
+            header = f.read(8)
+            if len(header) < 8:
+                break
+            item, length = struct.unpack("<II", header)
+            data = f.read(length)
+            if item >= len(batch):
+                print(f"Ignoring result for unknown batch item {item} in {output_path}")
+                continue
+            item_path = f"{output_path}.{batch[item]}"
+            with open(item_path, "wb") as item_file:
+                item_file.write(data)
+            results[batch[item]] = item_path
+    return results
+
+class RangeSource:
+    """Generates "start:end" tasks over an integer range on demand, with guided self-scheduling.
+
+    Every chunk is a share of what is left, so chunks start large (little per-task
+    overhead) and shrink toward the end (good load balance). A node's share is scaled
+    by its measured speed on the job relative to the other live nodes.
+    """
+    def __init__(self, binary_data, start, end, min_chunk=1, argument_format=RANGE_FORMAT, payload_files=None,
+                 job_id=None):
+        self.binary_data = binary_data
+        self.job_id = job_id
+        self.next_start = start
+        self.end = end
+        self.min_chunk = max(min_chunk, 1)
+        self.argument_format = argument_format
+        self.payload_files = payload_files
+        self.generated = 0
+
+    @property
+    def remaining(self):
+        return max(self.end - self.next_start, 0)
+
+    def chunk_size(self, ip_address, live_nodes):
+        node_count = max(len(live_nodes), 1)
+
+        # Relative speed of this node against the average over live nodes, 1 when unmeasured
+        speeds = {ip: 1.0 / m.seconds_per_work[self.job_id] for ip in live_nodes
+                  for m in [get_node_model(ip)] if m.seconds_per_work.get(self.job_id)}
+        speed_share = 1.0
+        if ip_address in speeds:
+            speed_share = speeds[ip_address] / (sum(speeds.values()) / len(speeds))
+
+        size = int(self.remaining * speed_share / (RANGE_GSS_DIVISOR * node_count))
+        return min(max(size, self.min_chunk), self.remaining)
+
+    def next_task(self, ip_address, live_nodes):
+        if not self.remaining:
+            return None
+        start = self.next_start
+        end = start + self.chunk_size(ip_address, live_nodes)
+        self.next_start = end
+
+        task = self.make_task(self.generated, start, end)
+        self.generated += 1
+        return task
+
+    def make_task(self, index, start, end):
+        argument = self.argument_format.format(start=start, end=end)
+        task = Task(binary_data=self.binary_data, payload_files=self.payload_files, argument=argument, work=end - start)
+        task.index = index
+        task.range = (start, end)
+        return task
+
+class NodeModel:
+    """Rolling estimate of a node's upload bandwidth and compute speed.
+
+    Both rates are exponentially weighted averages measured from completed tasks.
+    Task work is counted in a unit of the job's own (payload bytes, range size, batch
+    items), so the compute speed is kept per job.
+    Until a node has been measured they come from its benchmark profile, if it has one:
+    the bandwidth as measured, the compute speed scaled from the measured nodes by the
+    profiles' speed index. Without a profile the bandwidth is guessed from the beacon
+    RSSI and the compute speed is taken as the cluster average.
+    """
+    def __init__(self):
+        self.upload_bps = None  # Measured upload bandwidth (bytes per second)
+        self.seconds_per_work = {}  # Job id -> measured execution time per unit of the job's task work
+        self.rssi = None
+        self.completed = 0
+        self.profile_upload_bps = None  # Upload bandwidth from the node's benchmark profile
+        self.speed_index = None  # Compute speed from the node's benchmark profile, see profiles.speed_index
+
+    def apply_profile(self, rates):
+        self.profile_upload_bps = rates.get("upload")
+        self.speed_index = profiles.speed_index(rates)
+
+    def record_upload(self, nbytes, seconds):
+        if seconds > 0 and nbytes >= MODEL_MIN_UPLOAD_BYTES:
+            self.upload_bps = ewma(self.upload_bps, nbytes / seconds)
+
+    def record_execution(self, job_id, work, seconds):
+        self.seconds_per_work[job_id] = ewma(self.seconds_per_work.get(job_id), seconds / max(work, 1))
+        self.completed += 1
+
+    def upload_rate(self):
+        if self.upload_bps:
+            return self.upload_bps
+        if self.profile_upload_bps:
+            return self.profile_upload_bps
+
+        # Map RSSI from [-90, -30] dBm onto [0.1, 1.0] of the nominal bandwidth
+        rssi = self.rssi if isinstance(self.rssi, (int, float)) else -70
+        quality = min(max((rssi + 90) / 60, 0.1), 1.0)
+        return DEFAULT_UPLOAD_BPS * quality
+
+    def estimate(self, task):
+        """Expected seconds to upload and run `task` on this node."""
+        job_id = task_job_id(task)
+        seconds_per_work = self.seconds_per_work.get(job_id)
+        if seconds_per_work is None:
+            seconds_per_work = profiled_seconds_per_work(job_id, self.speed_index)
+        if seconds_per_work is None:
+            seconds_per_work = cluster_seconds_per_work(job_id)
+        upload_bytes = len(task.binary_data) + task.payload_bytes
+        return upload_bytes / self.upload_rate() + task.work * seconds_per_work
+
+def ewma(previous, sample):
+    return sample if previous is None else (1 - MODEL_ALPHA) * previous + MODEL_ALPHA * sample
+
+def get_node_model(ip_address):
+    with MODELS_LOCK:
+        model = NODE_MODELS.get(ip_address)
+        if model is None:
+            model = NODE_MODELS[ip_address] = NodeModel()
+        return model
+
+def task_job_id(task):
+    return task.job.id if task.job is not None else None
+
+def cluster_seconds_per_work(job_id):
+    """Average measured execution time per unit of a job's work over all nodes, 0 if nothing was measured yet."""
+    with MODELS_LOCK:
+        measured = [m.seconds_per_work[job_id] for m in NODE_MODELS.values() if job_id in m.seconds_per_work]
+    return sum(measured) / len(measured) if measured else 0.0
+
+def profiled_seconds_per_work(job_id, speed_index):
+    """Execution time per unit of work expected of an unmeasured node from its speed index, None if unknown.
+
+    Time per work is taken to scale inversely with the speed index, so measured nodes with a profile
+    give the constant of proportionality.
+    """
+    if speed_index is None:
+        return None
+    with MODELS_LOCK:
+        measured = [m.seconds_per_work[job_id] * m.speed_index for m in NODE_MODELS.values()
+                    if job_id in m.seconds_per_work and m.speed_index is not None]
+    return sum(measured) / len(measured) / speed_index if measured else None
+
+def handle_beacon(message, ip_address):
+    """Parse a node advertisement and refresh its entry in the membership table."""
+    try:
+        # Parse the incoming JSON message
+        node_info = json.loads(message.decode())
+    except (json.JSONDecodeError, UnicodeDecodeError):
+        print(f"Received invalid JSON from {ip_address}: {message!r}")
+        return
+
+    node_name = node_info.get("node", "Unknown")
+    mac_address = node_info.get("mac", "Unknown")
+    total_executed = node_info.get("total_executed", 0)
+    status = node_info.get("status", "unknown")
+    free_spiffs_bytes = node_info.get("free_spiffs_bytes", "unknown")
+    rssi = node_info.get("rssi", "unknown")
+    arch = node_info.get("arch", DEFAULT_ARCH)
+
+    with NODES_LOCK:
+        is_new = ip_address not in AVAILABLE_NODES
+
+        # Update the available nodes dictionary
+        AVAILABLE_NODES[ip_address] = {
+            "node_name": node_name,
+            "mac": mac_address,
+            "total_executed": total_executed,
+            "status": status,
+            "free_spiffs_bytes": free_spiffs_bytes,
+            "rssi": rssi,
+            "arch": arch,
+            "last_seen": time.time()
+        }
+
+    model = get_node_model(ip_address)
+    model.rssi = rssi
+    if is_new and PROFILE_STORE is not None and model.speed_index is None:
+        profile = PROFILE_STORE.latest(mac_address)
+        if profile:
+            model.apply_profile(profile["rates"])
+
+    if is_new:
+        print(f"Node found: {node_name} ({ip_address}), Arch: {arch}, Status: {status}, Free SPIFFS: {free_spiffs_bytes}, RSSI: {rssi}")
+
+def listen_for_nodes(duration=LISTEN_TIMEOUT, stop_event=None):
+    """Listen for node advertisements and update the available nodes list.
+
+    Listens for `duration` seconds, or until `stop_event` is set when `duration` is None.
+    """
     sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
     
     # Enable reuse of the address to avoid errors
@@ -51,7 +532,7 @@ def listen_for_nodes():
     # Bind to all interfaces and the broadcast port
     try:
         sock.bind(('', BROADCAST_PORT))  # Bind to the broadcast port
-        sock.settimeout(LISTEN_TIMEOUT)  # Set a timeout for listening
+        sock.settimeout(1)  # Wake up regularly to check for timeout or stop request
     except OSError as e:
         print(f"Failed to bind to port {BROADCAST_PORT}: {e}")
         return
@@ -60,44 +541,20 @@ def listen_for_nodes():
 
     try:
         while True:
-            try:
-                # Check if we've reached the timeout period
-                if time.time() - start_time > LISTEN_TIMEOUT:
-                    print(f"Listening completed")
-                    break
+            # Check if we've reached the timeout period or were asked to stop
+            if duration is not None and time.time() - start_time > duration:
+                print(f"Listening completed")
+                break
+            if stop_event is not None and stop_event.is_set():
+                break
 
+            try:
                 # Increase buffer size in case the message is larger than 1024 bytes
                 message, addr = sock.recvfrom(4096)
-                ip_address = addr[0]
-
-                try:
-                    # Parse the incoming JSON message
-                    node_info = json.loads(message.decode())
-                    node_name = node_info.get("node", "Unknown")
-                    mac_address = node_info.get("mac", "Unknown")
-                    total_executed = node_info.get("total_executed", 0)
-                    status = node_info.get("status", "unknown")
-                    free_spiffs_bytes = node_info.get("free_spiffs_bytes", "unknown")
-                    rssi = node_info.get("rssi", "unknown")
-
-                    # Update the available nodes dictionary
-                    AVAILABLE_NODES[ip_address] = {
-                        "node_name": node_name,
-                        "mac": mac_address,
-                        "total_executed": total_executed,
-                        "status": status,
-                        "free_spiffs_bytes": free_spiffs_bytes,
-                        "rssi": rssi
-                    }
-                    print(f"Node found: {node_name} ({ip_address}), Status: {status}, Free SPIFFS: {free_spiffs_bytes}, RSSI: {rssi}")
-
-                except json.JSONDecodeError:
-                    print(f"Received invalid JSON from {ip_address}: {message.decode()}")
-
             except socket.timeout:
-                # Timeout ends the listening period
-                print("Socket timed out")
-                break
+                continue
+
+            handle_beacon(message, addr[0])
 
     except OSError as e:
         print(f"Socket error occurred: {e}")
@@ -105,10 +562,51 @@ def listen_for_nodes():
     finally:
         sock.close()
 
+def start_node_listener():
+    """Keep the membership table up to date from a background thread for the whole run."""
+    stop_event = threading.Event()
+    listener = threading.Thread(target=listen_for_nodes, kwargs={"duration": None, "stop_event": stop_event}, daemon=True)
+    listener.start()
+    return stop_event
+
+def get_live_nodes():
+    """Drop nodes whose beacons stopped arriving and return a snapshot of the rest."""
+    now = time.time()
+    with NODES_LOCK:
+        for ip_address in list(AVAILABLE_NODES.keys()):
+            if now - AVAILABLE_NODES[ip_address]["last_seen"] > NODE_TIMEOUT:
+                print(f"Node lost: {ip_address}, no beacon for {NODE_TIMEOUT}s")
+                del AVAILABLE_NODES[ip_address]
+        return {ip: dict(info) for ip, info in AVAILABLE_NODES.items()}
+
+def node_arch(ip_address):
+    """Architecture a node announced in its beacon."""
+    with NODES_LOCK:
+        return AVAILABLE_NODES.get(ip_address, {}).get("arch", DEFAULT_ARCH)
+
+def binary_arch(binary_data):
+    """Architecture an ELF binary is built for, None for anything else, which is sent to every node."""
+    if len(binary_data) < 20 or binary_data[:4] != b"\x7fELF":
+        return None
+    byteorder = "little" if binary_data[5] == 1 else "big"
+    machine = int.from_bytes(binary_data[18:20], byteorder)
+    return ELF_MACHINES.get(machine, f"machine {machine}")
+
+def get_session(node_url):
+    """Return the pooled keep-alive session used for all calls to a node."""
+    with SESSIONS_LOCK:
+        session = NODE_SESSIONS.get(node_url)
+        if session is None:
+            session = requests.Session()
+            adapter = requests.adapters.HTTPAdapter(pool_connections=1, pool_maxsize=2)
+            session.mount("http://", adapter)
+            NODE_SESSIONS[node_url] = session
+        return session
+
 def check_node_status(node_url):
     """Check the availability of a node using the /status endpoint."""
     try:
-        response = requests.get(f"{node_url}/status")
+        response = get_session(node_url).get(f"{node_url}/status", timeout=(CONNECT_TIMEOUT, REQUEST_TIMEOUT))
         if response.status_code == 200:
             data = response.json()
             return data.get("status") == "available"
@@ -116,11 +614,42 @@ def check_node_status(node_url):
         print(f"Error checking status for {node_url}: {e}")
     return False
 
+def sync_node_clock(node_url):
+    """Offset from the node's trace clock (microseconds since boot) to ours, in seconds.
+
+    The node's reading is taken to be at the middle of the round trip, so the error is
+    at most half the shortest round trip seen. Returns None for nodes without /clock.
+    """
+    best = None
+    for _ in range(CLOCK_SYNC_SAMPLES):
+        sent = time.time()
+        response = get_session(node_url).get(f"{node_url}/clock", timeout=(CONNECT_TIMEOUT, REQUEST_TIMEOUT))
+        received = time.time()
+        if response.status_code != 200:
+            return None
+        if best is None or received - sent < best[0]:
+            best = (received - sent, (sent + received) / 2 - response.json()["now"] / 1e6)
+    return best[1]
+
+def fetch_node_trace(node_url):
+    """Drain the node's trace buffer, returns {"now", "dropped", "events"} or None for nodes without /trace."""
+    response = get_session(node_url).get(f"{node_url}/trace", timeout=(CONNECT_TIMEOUT, REQUEST_TIMEOUT))
+    if response.status_code != 200:
+        return None
+    return response.json()
+
 def upload_file(node_url, file_data, endpoint):
-    """Upload binary or payload to the node using the respective endpoint."""
+    """Upload binary or payload to the node using the respective endpoint.
+
+    `file_data` is bytes or a payload, which is streamed from its memory map.
+    """
+    if not isinstance(file_data, (Payload, BytesPayload)):
+        file_data = BytesPayload("file", file_data)
     try:
-        files = {'file': file_data}
-        response = requests.post(f"{node_url}/{endpoint}", files=files)        
+        with file_data.view() as view:
+            body = MultipartBody(view, os.path.basename(file_data.name))
+            response = get_session(node_url).post(f"{node_url}/{endpoint}", data=body, headers={"Content-Type": body.content_type},
+                                                  timeout=(CONNECT_TIMEOUT, REQUEST_TIMEOUT))
 
         if response.status_code == 200:            
             return True
@@ -131,31 +660,49 @@ def upload_file(node_url, file_data, endpoint):
         print(f"Error uploading file to {node_url}/{endpoint}: {e}")
         return False
 
-def submit_task(node_url, task):
+def submit_task(node_url, task, phases=None, binary=None):
+    """Upload and start a task; when given, `phases` receives (start, end) times of each step.
+
+    `binary` is the build of the task's binary for the node, the task's own by default.
+    """
     print(f"Submitting task to {node_url}")
+    binary = binary if binary is not None else task.binary_data
+    session = get_session(node_url)
+    phases = phases if phases is not None else {}
 
     try:
+        phases["upload"] = (time.time(), None)
+
         # Step 1: Upload binary file
-        binary_success = upload_file(node_url, task.binary_data, 'uploadbin')
+        binary_success = upload_file(node_url, binary, 'uploadbin')
+        phases["binary"] = (phases["upload"][0], time.time())
         if not binary_success:
             return False
 
         # Step 2: Upload payload files (if any)
         if task.payloads:
+            payload_start = time.time()
             for filename, file_data in task.payloads.items():
                 payload_success = upload_file(node_url, file_data, f'uploadpayload?filename={filename}')
                 if not payload_success:
                     return False
+            phases["payload"] = (payload_start, time.time())
 
         # Step 3: Send argument (MAC address or other parameters)
         if task.argument:
-            response = requests.post(f"{node_url}/arg", data=task.argument)
+            arg_start = time.time()
+            response = session.post(f"{node_url}/arg", data=task.argument, timeout=(CONNECT_TIMEOUT, REQUEST_TIMEOUT))
+            phases["arg"] = (arg_start, time.time())
             if response.status_code != 200:
                 print(f"Failed to send argument to {node_url}: {response.status_code}")
                 return False
 
+        phases["upload"] = (phases["upload"][0], time.time())
+
         # Step 4: Execute the task on the ESP32 node
-        response = requests.post(f"{node_url}/execute")
+        execute_start = time.time()
+        response = session.post(f"{node_url}/execute", timeout=(CONNECT_TIMEOUT, REQUEST_TIMEOUT))
+        phases["execute"] = (execute_start, time.time())
         print(f"{response.text}")
 
         if response.status_code == 200:
@@ -169,21 +716,35 @@ def submit_task(node_url, task):
         print(f"Error submitting task to {node_url}: {e}")
         return False
 
-def get_task_output(node_url):
+def fetch_task_output(node_url, timeout, output_path, phases=None):
+    """Download the task output file to `output_path`, raising requests.RequestException on transport errors.
+
+    Nodes serve HTTP from the same loop that runs the task, so the request is only
+    answered once the task has finished. Returns None if the task left no output.
+    When given, `phases` receives the (start, end) times of the run and the download.
+    """
+    phases = phases if phases is not None else {}
+
+    # Make a GET request to the /output endpoint
+    run_start = time.time()
+    response = get_session(node_url).get(f"{node_url}/output", stream=True, timeout=(CONNECT_TIMEOUT, timeout))
+    phases["run"] = (run_start, time.time())
+    if response.status_code != 200:
+        print(f"Failed to get output from {node_url}: {response.status_code}")
+        return None
+
+    download_start = time.time()
+    with open(output_path, "wb") as output_file:
+        for chunk in response.iter_content(chunk_size=8192):
+            if chunk:
+                output_file.write(chunk)
+    phases["download"] = (download_start, time.time())
+    return output_path
+
+def get_task_output(node_url, output_path):
     """Retrieve the task output file from the node using the /output endpoint."""
     try:
-        # Make a GET request to the /output endpoint
-        response = requests.get(f"{node_url}/output", stream=True)
-        if response.status_code == 200:
-            # Use node IP and task ID or timestamp to generate a unique filename
-            output_file_path = f"output_from_{node_url.replace('http://', '').replace('.', '_')}_{int(time.time())}.txt"
-            with open(output_file_path, "wb") as output_file:
-                for chunk in response.iter_content(chunk_size=8192):
-                    if chunk:
-                        output_file.write(chunk)
-            return output_file_path
-        else:
-            print(f"Failed to get output from {node_url}: {response.status_code}")
+        return fetch_task_output(node_url, REQUEST_TIMEOUT, output_path)
     except requests.RequestException as e:
         print(f"Error retrieving output from {node_url}: {e}")
     return None
@@ -194,104 +755,985 @@ def manage_nodes():
     listen_for_nodes()
 
     print("\nAvailable Nodes:")
-    for ip, info in AVAILABLE_NODES.items():
+    for ip, info in get_live_nodes().items():
         print(f"IP: {ip}, Node: {info['node_name']}, MAC: {info['mac']}, Total Executed: {info['total_executed']}, Status: {info['status']}")
     print("\n")
 
-def queue_tasks(binary_file, payload_files, arguments):
-    """Submit tasks to available nodes with optional payload files and arguments."""
+def wait_for_nodes(timeout=LISTEN_TIMEOUT):
+    """Start background membership tracking and give nodes one listening period to announce themselves."""
     print("Listening for node broadcasts...")
-    listen_for_nodes()
-
-    # Read the binary file in binary mode
-    with open(binary_file, "rb") as bin_file:
-        binary_data = bin_file.read()
+    stop_event = start_node_listener()
+    time.sleep(timeout)
+    print("Listening completed")
+    return stop_event
+
+class Job:
+    """A submitted job: its queued tasks and everything that consumes their outputs.
+
+    Jobs share the nodes by priority with stride scheduling. Every task handed out
+    charges its job the node time a task of that job takes on average, divided by the
+    job's priority, and the job charged least so far goes next. A job of priority 2
+    thus gets about twice the node time of a job of priority 1.
+
+    `builds` maps node architectures to builds of the job's binary, a build under None
+    runs on every node. The tasks carry the first build, nodes get the one for their
+    architecture, and nodes without a build are left to other jobs.
+    """
+    def __init__(self, job_id, builds, priority=1, reduce_stage=None, source=None, job_journal=None, result_cache=None):
+        self.id = job_id
+        self.builds = builds
+        self.binary_data = next(iter(builds.values()))
+        if len(builds) == 1:
+            self.binary_hash = hashlib.sha256(self.binary_data).hexdigest()
+        else:
+            # The builds compute the same outputs, so they share one hash for the cache and the journal
+            hashes = sorted(hashlib.sha256(data).hexdigest() for data in builds.values())
+            self.binary_hash = hashlib.sha256("".join(hashes).encode()).hexdigest()
+        self.priority = priority
+        self.queue = deque()
+        self.source = source  # Optional generator of tasks on demand, used once the queue is empty
+        self.reduce_stage = reduce_stage
+        self.journal = job_journal  # Optional journal recording assignments and completions
+        self.cache = result_cache  # Optional ResultCache for outputs of previously run tasks
+        self.attach = {}  # ip -> task an earlier run of the job left on the node
+        self.completed = 0
+        self.delivering = 0  # Finished tasks whose outputs are still being handed on
+        self.task_seconds = None  # Rolling average of the node time one task takes
+        self.pass_value = 0.0  # Node time charged so far, divided by the priority
+        self.state = "queued"
+        self.submitted = time.time()
+        self.finished = None
+
+    def adopt(self, task):
+        task.job = self
+        task.binary_hash = self.binary_hash
+        return task
+
+    def runs_on(self, arch):
+        return None in self.builds or arch in self.builds
+
+    def build_for(self, arch):
+        return self.builds.get(arch, self.builds.get(None))
+
+    def has_queued(self):
+        if self.state in ("done", "cancelled"):
+            return False
+        return bool(self.queue) or bool(self.source and self.source.remaining)
+
+    def cancel(self):
+        """Drop the queued tasks, tasks already running finish and are kept."""
+        self.state = "cancelled"
+        self.queue.clear()
+        if self.source:
+            self.source.next_start = self.source.end
+
+    def finish(self):
+        if self.state != "cancelled":
+            self.state = "done"
+        self.finished = time.time()
+        if self.journal:
+            self.journal.close()
+
+    def status(self, running=0, stored=0):
+        status = {"id": self.id, "state": self.state, "priority": self.priority,
+                  "submitted": self.submitted, "finished": self.finished,
+                  "queued": len(self.queue), "running": running, "completed": self.completed,
+                  "results": stored}
+        if self.source:
+            status["range_remaining"] = self.source.remaining
+        if self.reduce_stage and self.state in ("done", "cancelled"):
+            status["result"] = self.reduce_stage.result()
+        return status
+
+def make_reduce_stage(reduce_spec):
+    """Reduce stage for a "name[:param]" spec, None without a spec. Raises ValueError for a bad spec."""
+    if not reduce_spec:
+        return None
+    try:
+        return reducers.ReduceStage(reducers.make_reducer(reduce_spec))
+    except OSError as e:
+        raise ValueError(str(e))
+
+def read_builds(binary_file):
+    """Read a binary, or a list of builds of it, keyed by the architecture each is built for."""
+    builds = {}
+    for path in [binary_file] if isinstance(binary_file, str) else binary_file:
+        if not os.path.isfile(path):
+            raise ValueError(f"File {path} not found!")
+        with open(path, "rb") as bin_file:
+            binary_data = bin_file.read()
+        arch = binary_arch(binary_data)
+        if arch in builds:
+            raise ValueError(f"Two builds for {arch or 'every architecture'}: {path}")
+        builds[arch] = binary_data
+    if not builds:
+        raise ValueError("A job needs a binary.")
+    return builds
+
+def build_job(job_id, binary_file, payload_files, arguments, shard_input=None, shard_count=0, record_size=0,
+              overlap=0, reduce_stage=None, task_range=None, min_chunk=1, range_format=RANGE_FORMAT,
+              batch_size=0, journaled=False, result_cache=None, priority=1):
+    """Turn a submission into a Job with its tasks queued. Raises ValueError for an invalid submission.
+
+    `binary_file` is a binary, or a list of builds of it for different architectures.
+    """
+    builds = read_builds(binary_file)
+
+    # A journaled job keeps a journal, so a rerun with the same id skips the work already done
+    job_journal = None
+    if journaled:
+        os.makedirs(JOURNAL_DIR, exist_ok=True)
+        job_journal = journal.Journal(os.path.join(JOURNAL_DIR, f"{job_id}.journal"))
+
+    job = Job(job_id, builds, priority, reduce_stage, None, job_journal, result_cache)
+    try:
+        if job_journal and not job_journal.start(job.binary_hash):
+            raise ValueError(f"Job {job_id} was started with a different binary.")
+        queue_job_tasks(job, payload_files, arguments, shard_input, shard_count, record_size, overlap,
+                        task_range, min_chunk, range_format, batch_size)
+        if job_journal:
+            resume_job(job)
+    except ValueError:
+        if job_journal:
+            job_journal.close()
+        raise
+    return job
+
+def queue_job_tasks(job, payload_files, arguments, shard_input, shard_count, record_size, overlap,
+                    task_range, min_chunk, range_format, batch_size):
+    binary_data = job.binary_data
+    queue = job.queue
+
+    # Scenario: An integer range split into "start:end" arguments on demand, with at most one payload
+    if task_range:
+        if arguments or shard_input or len(payload_files) > 1:
+            raise ValueError("A range takes no arguments, no sharding and at most one payload file.")
+        start, end = task_range
+        job.source = RangeSource(binary_data, start, end, min_chunk, range_format, payload_files or None, job.id)
+        print(f"Splitting range {start}:{end} into chunks of at least {min_chunk}")
+
+    # Scenario: Many small items packed into batches, each batch processed by one execution
+    elif batch_size:
+        if payload_files or shard_input or not arguments:
+            raise ValueError("Batching packs arguments only, give them with -a.")
+        for first in range(0, len(arguments), batch_size):
+            items = arguments[first:first + batch_size]
+            task = Task(binary_data=binary_data, payload_files=[BytesPayload("batch", build_batch_payload(items))], argument=None, work=len(items))
+            task.batch = list(range(first, first + len(items)))
+            task.items = items
+            queue.append(task)
+        print(f"Packed {len(arguments)} items into {len(queue)} batches")
+
+    # Scenario: One large input split into record-aligned shards, each with the same optional argument
+    elif shard_input:
+        if payload_files or len(arguments) > 1:
+            raise ValueError("Sharding takes no payload files and at most one argument.")
+        if not os.path.isfile(shard_input):
+            raise ValueError(f"File {shard_input} not found!")
+        if not shard_count:
+            shard_count = plan_shard_count(os.path.getsize(shard_input), get_live_nodes())
+        argument = arguments[0] if arguments else None
+        shards = shard_file(shard_input, shard_count, record_size, overlap)
+        print(f"Split {shard_input} into {len(shards)} shards")
+        for shard in shards:
+            task = Task(binary_data=binary_data, payload_files=[shard], argument=argument, work=shard.work)
+            queue.append(task)
 
     # Scenario: Matching number of payloads and arguments
-    if payload_files and arguments and len(payload_files) == len(arguments):
+    elif payload_files and arguments and len(payload_files) == len(arguments):
         # Create a task for each payload-argument pair
         for i in range(len(payload_files)):
             task = Task(binary_data=binary_data, payload_files=[payload_files[i]], argument=arguments[i])
-            TASK_QUEUE.append(task)
-    
+            queue.append(task)
+
     # Scenario: Multiple payloads but no arguments
     elif payload_files and not arguments:
         for payload_file in payload_files:
             task = Task(binary_data=binary_data, payload_files=[payload_file], argument=None)
-            TASK_QUEUE.append(task)
+            queue.append(task)
 
     # Scenario: Multiple arguments but no payloads
     elif arguments and not payload_files:
         for argument in arguments:
             task = Task(binary_data=binary_data, payload_files=None, argument=argument)
-            TASK_QUEUE.append(task)
+            queue.append(task)
 
     # Scenario: Mismatched number of payloads and arguments or other scenarios
     elif payload_files and arguments and len(payload_files) != len(arguments):
-        print("Error: Mismatched number of payloads and arguments. Please provide equal numbers of each.")
-        return
+        raise ValueError("Mismatched number of payloads and arguments. Please provide equal numbers of each.")
 
     # Scenario: Neither payloads nor arguments provided
     else:
         task = Task(binary_data=binary_data, payload_files=None, argument=None)
-        TASK_QUEUE.append(task)
+        queue.append(task)
+
+    for index, task in enumerate(queue):
+        task.index = index
+        job.adopt(task)
+
+def queue_tasks(binary_file, payload_files, arguments, max_workers=MAX_CONCURRENCY,
+                shard_input=None, shard_count=0, record_size=0, overlap=0, reduce_spec=None,
+                task_range=None, min_chunk=1, range_format=RANGE_FORMAT, batch_size=0, job_id=None,
+                result_cache=None, result_store=None, trace_path=None):
+    """Submit tasks to available nodes with optional payload files and arguments."""
+    # Set up the reducer first so a bad spec fails before any work is done
+    try:
+        reduce_stage = make_reduce_stage(reduce_spec)
+    except ValueError as e:
+        print(f"Error: {e}")
+        return
+
+    task_timeline = timeline.Timeline() if trace_path else None
+    discovery_start = time.time()
+    stop_event = wait_for_nodes()
+    if task_timeline:
+        task_timeline.span("discovery", discovery_start, time.time())
+
+    try:
+        build_start = time.time()
+        job = build_job(job_id or uuid.uuid4().hex[:8], binary_file, payload_files, arguments, shard_input,
+                        shard_count, record_size, overlap, reduce_stage, task_range, min_chunk, range_format,
+                        batch_size, bool(job_id), result_cache)
+        if task_timeline:
+            task_timeline.span("queue tasks", build_start, time.time())
+    except ValueError as e:
+        print(f"Error: {e}")
+        stop_event.set()
+        return
 
     # Submit tasks to available nodes
-    manage_task_submission()
-
-
-def manage_task_submission():
-    """Assign tasks to available nodes and manage the task queue."""
-    active_tasks = {}
-
-    # Continue running as long as there are tasks in the queue or nodes still processing tasks
-    while TASK_QUEUE or active_tasks:
-        # Poll each node's status and try to submit tasks when available
-        for ip_address, node_info in AVAILABLE_NODES.items():
-            node_url = f"http://{ip_address}"
-
-            # Check if the node is busy, if yes, check its status periodically
-            if ip_address not in active_tasks:  # Only check nodes not already running a task
-                node_status = node_info["status"]
-
-                if node_status == "available":
-                    if TASK_QUEUE:  # Submit a task if there's one in the queue
-                        task = TASK_QUEUE.popleft()
-                        success = submit_task(node_url, task)
-
-                        if success:
-                            active_tasks[ip_address] = task  # Track active task on the node
-                        else:
-                            print(f"Failed to submit task to {ip_address}. Requeuing task.")
-                            TASK_QUEUE.appendleft(task)  # Requeue the task on failure
-
-                elif node_status == "busy":
-                    # Periodically poll the node for availability
-                    if check_node_status(node_url):  # If the node is now available, submit a task
-                        if TASK_QUEUE:
-                            task = TASK_QUEUE.popleft()
-                            success = submit_task(node_url, task)
-
-                            if success:
-                                active_tasks[ip_address] = task  # Track active task on the node
-                            else:
-                                print(f"Failed to submit task to {ip_address}. Requeuing task.")
-                                TASK_QUEUE.appendleft(task)  # Requeue the task on failure
-
-        # Check for completed tasks and free up nodes
-        for ip_address in list(active_tasks.keys()):
-            node_url = f"http://{ip_address}"
-            output = get_task_output(node_url)
-
-            if output:
-                print(f"Output from {ip_address}: {output}")
-                del active_tasks[ip_address]  # Remove from active tasks, node is now free
-
-        # Wait for a short interval before polling again to avoid busy-waiting
-        time.sleep(POLL_INTERVAL)
-
-def retrieve_outputs():
-    """Retrieve task outputs from available nodes."""
+    manage_task_submission(job, result_store or results.ResultStore(RESULTS_DIR), max_workers, task_timeline)
+    stop_event.set()
+
+    if reduce_stage:
+        print("Reduced result:")
+        print(reduce_stage.result())
+
+    if task_timeline:
+        task_timeline.write(trace_path)
+        print(task_timeline.report())
+        print(f"Trace written to {trace_path}, open it in https://ui.perfetto.dev")
+
+
+def resume_job(job):
+    """Bring the job's queue in line with its journal from an earlier run.
+
+    Completed tasks are dropped (their outputs are replayed into the reducer), range
+    chunks that were handed out but never completed are queued again, and tasks that
+    were running when the commander died are left in job.attach as {ip: task} to
+    re-attach to. Raises ValueError if the journal was written for different tasks.
+    """
+    job_journal, source, queue = job.journal, job.source, job.queue
+
+    # Queued tasks must match what the journal recorded for them
+    for task in queue:
+        definition = job_journal.definitions.get(task.index)
+        if definition is not None and definition != json.loads(json.dumps(task.describe())):
+            raise ValueError(f"Task {task.index} differs from the journal, the job id was used for another job.")
+
+    # Range chunks already generated in the earlier run
+    generated = {task_id: d for task_id, d in job_journal.definitions.items() if "range" in d}
+    if generated:
+        if source is None:
+            raise ValueError("The journal holds range chunks but no --range was given.")
+        source.next_start = max(d["range"][1] for d in generated.values())
+        source.generated = max(generated) + 1
+        for task_id in sorted(generated):
+            if task_id not in job_journal.completed:
+                start, end = generated[task_id]["range"]
+                queue.append(job.adopt(source.make_task(task_id, start, end)))
+
+    # Skip completed work, feeding the outputs still on disk to the reducer
+    for task_id, record in sorted(job_journal.completed.items()):
+        items = record.get("items")
+        results = {int(p): path for p, path in items.items()} if items is not None else {task_id: record["output"]}
+        for position, path in sorted(results.items()):
+            if job.reduce_stage:
+                job.reduce_stage.add(position, path if path and os.path.exists(path) else None)
+        job.completed += 1
+    remaining = [task for task in queue if task.index not in job_journal.completed]
+    if job_journal.definitions:
+        print(f"Resuming job: {len(job_journal.completed)} tasks already completed, {len(remaining)} left")
+    queue.clear()
+    queue.extend(remaining)
+
+    # Re-attach to nodes still running (or holding the output of) a task of this job.
+    # A node's executed count tells whether it is still on our task or finished it.
+    live_nodes = get_live_nodes()
+    for task in list(queue):
+        record = job_journal.assignments.get(task.index)
+        if record is None or record["node"] not in live_nodes or record["node"] in job.attach:
+            continue
+        node_info = live_nodes[record["node"]]
+        executed = node_info["total_executed"] - record["total_executed"]
+        if (node_info["status"] == "busy" and executed == 0) or (node_info["status"] == "available" and executed == 1):
+            print(f"Re-attaching to task {task.index} on {record['node']}")
+            queue.remove(task)
+            job.attach[record["node"]] = task
+
+class Dispatcher:
+    """Runs one worker loop per live node so a slow node never holds up the others.
+
+    Each worker asks for a task placed for its node, submits it and waits for the
+    output, then repeats. At most `max_workers` tasks are in flight at once. Tasks
+    come from every job added to the dispatcher, shared out by priority (see Job).
+
+    Once the queues are drained, idle nodes run backup copies of tasks that take far
+    longer than their node's model predicts. The first copy to finish wins and the
+    output of any other copy is ignored.
+
+    A node that stops beaconing has its running task requeued right away, rather than
+    when its worker gives up waiting; should the node still deliver, the output is dropped.
+    """
+    def __init__(self, result_store, max_workers=MAX_CONCURRENCY, task_timeline=None):
+        self.max_workers = max_workers
+        self.store = result_store  # Where outputs are kept, indexed by job and position
+        self.timeline = task_timeline  # Optional Timeline recording the phases of every task
+        self.lock = threading.Lock()
+        self.jobs = {}  # id -> Job, finished ones included
+        self.workers = {}  # ip -> worker thread
+        self.retry_at = {}  # ip -> time before which a failed node is left alone
+        self.running = {}  # ip -> (task, start time) of the task the node is working on
+        self.executed = {}  # ip -> tasks the node has executed, counting ones its beacon hasn't reported yet
+        self.node_clocks = {}  # ip -> (offset, synced at, node's last reading) or None if the node can't trace
+
+    def add_job(self, job):
+        with self.lock:
+            # Start level with the jobs already running, so the new job neither starves them nor waits for them
+            passes = [other.pass_value for other in self.active_jobs()]
+            if passes:
+                job.pass_value = max(job.pass_value, min(passes))
+            self.jobs[job.id] = job
+        print(f"Job {job.id}: {len(job.queue)} tasks queued, priority {job.priority}")
+        if job.cache and job.queue:
+            threading.Thread(target=self.serve_from_cache, args=(job,), daemon=True).start()
+        for ip_address, task in job.attach.items():
+            self.attach(ip_address, task)
+
+    def active_jobs(self):
+        return [job for job in self.jobs.values() if job.state in ("queued", "running")]
+
+    def task_charge(self, job):
+        """Node time charged to a job per task handed out, 1 for every job until tasks were measured."""
+        if job.task_seconds is not None:
+            return job.task_seconds
+        measured = [other.task_seconds for other in self.jobs.values() if other.task_seconds is not None]
+        return sum(measured) / len(measured) if measured else 1.0
+
+    def next_task(self, ip_address):
+        arch = node_arch(ip_address)
+        with self.lock:
+            task, declined = None, False
+            for job in sorted(self.active_jobs(), key=lambda job: job.pass_value):
+                if not job.runs_on(arch):
+                    continue
+                if job.queue:
+                    index = self.place(ip_address, job.queue)
+                    if index is None:
+                        declined = True  # Another job's task may still suit this node
+                        continue
+                    task = job.queue[index]
+                    del job.queue[index]
+                elif job.has_queued():
+                    task = job.adopt(job.source.next_task(ip_address, get_live_nodes()))
+                else:
+                    continue
+                job.pass_value += self.task_charge(job) / job.priority
+                job.state = "running"
+                break
+            if task is None:
+                if declined:
+                    return None
+                task = self.find_straggler(ip_address)
+                if task is None:
+                    return None
+                print(f"Launching backup copy of {task} on {ip_address}")
+            task.copies += 1
+            self.running[ip_address] = (task, time.time())
+
+        job_journal = task.job.journal
+        if job_journal:
+            job_journal.define(task.index, task.describe())
+            total_executed = get_live_nodes().get(ip_address, {}).get("total_executed", 0)
+            with self.lock:
+                total_executed = max(total_executed, self.executed.get(ip_address, 0))
+            job_journal.assign(task.index, ip_address, total_executed)
+        return task
+
+    def attach(self, ip_address, task):
+        """Wait for the output of a task that a previous run already started on a node."""
+        with self.lock:
+            task.copies += 1
+            self.running[ip_address] = (task, time.time())
+        worker = threading.Thread(target=self.worker, args=(ip_address, "available", task), daemon=True)
+        self.workers[ip_address] = worker
+        worker.start()
+
+    def find_straggler(self, ip_address):
+        """Return the running task that is most overdue relative to its node's model, if any."""
+        now = time.time()
+        arch = node_arch(ip_address)
+        worst, worst_ratio = None, SPECULATION_FACTOR
+        for ip, (task, started) in self.running.items():
+            if ip == ip_address or task.done or task.copies > 1 or task.job.state == "cancelled":
+                continue
+            if not task.job.runs_on(arch):
+                continue
+            if cluster_seconds_per_work(task.job.id) == 0.0:
+                continue  # Nothing of the job measured yet, so there is no expectation to be late against
+            elapsed = now - started
+            expected = get_node_model(ip).estimate(task)
+            if elapsed < SPECULATION_MIN_SECONDS or expected <= 0:
+                continue
+            if elapsed / expected > worst_ratio:
+                worst, worst_ratio = task, elapsed / expected
+        return worst
+
+    def place(self, ip_address, queue):
+        """Pick the index of the queued task that suits this node best, None to leave the node idle.
+
+        Among the first PLACEMENT_WINDOW tasks, the fastest nodes take the most expensive
+        ones and the slowest the cheapest. Once fewer tasks remain than there are nodes,
+        a node declines a task that some other node is expected to finish much sooner.
+        """
+        live_nodes = get_live_nodes()
+        window = [queue[i] for i in range(min(len(queue), PLACEMENT_WINDOW))]
+        model = get_node_model(ip_address)
+
+        # Rank the nodes able to run the job by their expected time for the head task, fastest first
+        job = window[0].job
+        others = [ip for ip in live_nodes if ip != ip_address and job.runs_on(live_nodes[ip].get("arch", DEFAULT_ARCH))]
+        ranked = sorted([ip_address] + others, key=lambda ip: get_node_model(ip).estimate(window[0]))
+        fraction = ranked.index(ip_address) / (len(ranked) - 1) if len(ranked) > 1 else 0.0
+
+        # Order the window by cost, most expensive first, and take the slot matching our rank
+        by_cost = sorted(range(len(window)), key=lambda i: -model.estimate(window[i]))
+        index = by_cost[round(fraction * (len(by_cost) - 1))]
+
+        if len(queue) < len(others) + 1:
+            task = window[index]
+            now = time.time()
+            mine = model.estimate(task)
+            for ip in others:
+                remaining = 0.0
+                if ip in self.running:
+                    running_task, started = self.running[ip]
+                    remaining = max(get_node_model(ip).estimate(running_task) - (now - started), 0.0)
+                if remaining + get_node_model(ip).estimate(task) * DECLINE_RATIO < mine:
+                    return None
+        return index
+
+    def owns(self, ip_address, task):
+        """Whether the node still runs the task, False once the task was taken back from a lost node."""
+        entry = self.running.get(ip_address)
+        return entry is not None and entry[0] is task
+
+    def reclaim_lost(self, live_nodes):
+        """Requeue the tasks of nodes that stopped beaconing, their workers drop any late output."""
+        with self.lock:
+            lost = [(ip, task) for ip, (task, _) in self.running.items() if ip not in live_nodes]
+        for ip_address, task in lost:
+            print(f"Node {ip_address} lost while running {task}. Requeuing task.")
+            self.requeue(ip_address, task)
+
+    def requeue(self, ip_address, task):
+        with self.lock:
+            if not self.owns(ip_address, task):
+                return  # Requeued already when the node was lost
+            self.running.pop(ip_address)
+            task.copies -= 1
+            # Only requeue if no other copy is still running or has already finished
+            if not task.done and task.copies == 0 and task.job.state != "cancelled":
+                task.job.queue.appendleft(task)
+            self.retry_at[ip_address] = time.time() + FAILURE_BACKOFF
+        if task.job.journal and not task.done:
+            task.job.journal.fail(task.index, ip_address)
+
+    def complete(self, ip_address, task):
+        """Mark a copy of the task finished, return False if another copy finished first or the node was lost."""
+        with self.lock:
+            if not self.owns(ip_address, task):
+                return False
+            _, started = self.running.pop(ip_address)
+            beacon_count = get_live_nodes().get(ip_address, {}).get("total_executed", 0)
+            self.executed[ip_address] = max(self.executed.get(ip_address, 0), beacon_count - 1) + 1
+            task.copies -= 1
+            if task.done:
+                return False
+            task.done = True
+            task.job.task_seconds = ewma(task.job.task_seconds, time.time() - started)
+            task.job.delivering += 1
+            return True
+
+    def job_status(self, job):
+        with self.lock:
+            running = self.job_running(job)
+        return job.status(running, self.store.count(job.id))
+
+    def job_running(self, job):
+        return sum(1 for task, _ in self.running.values() if task.job is job and not task.done)
+
+    def finish_jobs(self):
+        """Close the jobs with nothing left queued, running or being delivered."""
+        with self.lock:
+            finished = [job for job in self.jobs.values() if job.finished is None and not job.has_queued()
+                        and not job.delivering and not self.job_running(job)]
+        for job in finished:
+            job.finish()
+            print(f"Job {job.id} {job.state}: {job.completed} tasks completed")
+
+    def is_done(self):
+        with self.lock:
+            return all(job.finished is not None for job in self.jobs.values())
+
+    def has_work(self):
+        with self.lock:
+            return any(job.has_queued() for job in self.active_jobs()) or \
+                any(not task.done for task, _ in self.running.values())
+
+    def worker(self, ip_address, node_status, attached=None):
+        node_url = f"http://{ip_address}"
+        model = get_node_model(ip_address)
+
+        # Busy nodes are left alone until they report back as available
+        if node_status == "busy" and not check_node_status(node_url):
+            with self.lock:
+                self.retry_at[ip_address] = time.time() + FAILURE_BACKOFF
+            return
+
+        while True:
+            phases = {}
+            if attached is not None:
+                # Started by a previous run, only the output is left to collect
+                task, attached = attached, None
+                assigned = time.time()
+            else:
+                task = self.next_task(ip_address)
+                if task is None:
+                    return
+                assigned = time.time()
+                phases["queued"] = (task.created, assigned)
+
+                if not submit_task(node_url, task, phases, task.job.build_for(node_arch(ip_address))):
+                    print(f"Failed to submit task to {ip_address}. Requeuing task.")
+                    self.requeue(ip_address, task)
+                    self.trace(ip_address, task, assigned, phases, None, "failed")
+                    return
+
+            output_path = self.store.incoming(task.job.id)
+            try:
+                output = fetch_task_output(node_url, TASK_TIMEOUT, output_path, phases)
+            except requests.RequestException as e:
+                print(f"Error retrieving output from {node_url}: {e}. Requeuing task.")
+                if os.path.exists(output_path):
+                    os.remove(output_path)
+                self.requeue(ip_address, task)
+                self.trace(ip_address, task, assigned, phases, None, "failed")
+                return
+
+            # Learn the node's speed from this task
+            if "upload" in phases:
+                upload_start, upload_end = phases["upload"]
+                binary_bytes = len(task.job.build_for(node_arch(ip_address)))
+                model.record_upload(binary_bytes + task.payload_bytes, upload_end - upload_start)
+                run_start, run_end = phases["run"]
+                model.record_execution(task.job.id, task.work, run_end - run_start)
+
+            if not self.complete(ip_address, task):
+                print(f"Ignoring late or duplicate result of {task} from {ip_address}")
+                self.trace(ip_address, task, assigned, phases, output, "duplicate")
+                if output:
+                    os.remove(output)
+            else:
+                if not output:
+                    print(f"Task on {ip_address} finished without output")
+                job = task.job
+                if job.cache and output:
+                    if task.cache_key is None:
+                        task.cache_key = job.cache.key(task.binary_hash, task.payloads, task.argument)
+                    job.cache.store(task.cache_key, output)
+                output_bytes = os.path.getsize(output) if output else 0
+                deliver_start = time.time()
+                self.deliver(ip_address, task, output)
+                phases["deliver"] = (deliver_start, time.time())
+                self.trace(ip_address, task, assigned, phases, output_bytes, "completed")
+
+    def trace(self, ip_address, task, assigned, phases, output, outcome):
+        """Add a task run to the timeline, `output` is the output file or its size."""
+        if self.timeline is None:
+            return
+        if isinstance(output, str):
+            output = os.path.getsize(output)
+        bytes_up = 0
+        if "binary" in phases:
+            binary_bytes = len(task.job.build_for(node_arch(ip_address)))
+            bytes_up = binary_bytes + task.payload_bytes + len((task.argument or "").encode())
+        self.timeline.task(ip_address, f"{task.job.id}:{task.index}", assigned, time.time(), phases,
+                           bytes_up, output or 0, outcome)
+        self.collect_node_trace(ip_address)
+
+    def collect_node_trace(self, ip_address):
+        """Add the node's own events since the last collection to the timeline, on our clock."""
+        node_url = f"http://{ip_address}"
+        clock = self.node_clocks.get(ip_address, ())
+        if clock is None:
+            return
+        try:
+            trace = fetch_node_trace(node_url)
+            if trace is None:
+                print(f"Node {ip_address} does not record a trace")
+                self.node_clocks[ip_address] = None
+                return
+            # Measure the offset again once it may have drifted, or when the node rebooted and its clock restarted
+            if not clock or time.time() - clock[1] > CLOCK_SYNC_INTERVAL or trace["now"] < clock[2]:
+                offset = sync_node_clock(node_url)
+                if offset is None:
+                    self.node_clocks[ip_address] = None
+                    return
+                clock = (offset, time.time(), trace["now"])
+            self.node_clocks[ip_address] = (clock[0], clock[1], trace["now"])
+        except (requests.RequestException, ValueError, KeyError) as e:
+            print(f"Error collecting the trace of {ip_address}: {e}")
+            return
+        if trace["dropped"]:
+            print(f"Node {ip_address} overwrote {trace['dropped']} trace events, collect more often or enlarge TRACE_EVENTS")
+        self.timeline.node_events(ip_address, trace["events"], clock[0])
+
+    def deliver(self, ip_address, task, output):
+        """Hand the output of a finished task to the result store, its job's journal and reducer."""
+        job = task.job
+        if task.batch and output:
+            # One result per packed item, in the job's item order
+            item_results = split_batch_output(output, task.batch)
+            missing = [position for position, path in item_results.items() if path is None]
+            print(f"Split batch into {len(item_results) - len(missing)} item results, {len(missing)} missing")
+            os.remove(output)
+            output = None
+        elif task.batch:
+            item_results = {position: None for position in task.batch}
+        else:
+            item_results = {task.index: output}
+
+        arguments = dict(zip(task.batch, task.items)) if task.batch else {task.index: task.argument}
+        for position, path in item_results.items():
+            if path:
+                item_results[position] = self.store.add(job.id, position, path, task.index, arguments[position], ip_address)
+        if output:
+            output = item_results[task.index]
+            print(f"Output from {ip_address}: {output}")
+
+        if job.journal:
+            job.journal.complete(task.index, ip_address, output, item_results if task.batch else None)
+        if job.reduce_stage:
+            for position, path in sorted(item_results.items()):
+                job.reduce_stage.add(position, path)
+        with self.lock:
+            job.completed += 1
+            job.delivering -= 1
+
+    def serve_from_cache(self, job):
+        """Complete queued tasks of a job whose output is already in the result cache.
+
+        Runs next to the dispatch loop, since hashing payloads means reading them all;
+        tasks a node picks up before their turn here simply run.
+        """
+        hits = 0
+        with self.lock:
+            queued = list(job.queue)
+        for task in queued:
+            if task.copies or task.done:
+                continue
+            task.cache_key = job.cache.key(task.binary_hash, task.payloads, task.argument)
+            output = self.store.incoming(job.id)
+            # Copy without holding the dispatcher lock, then take the task only if no node took it meanwhile
+            if not job.cache.lookup(task.cache_key, output):
+                continue
+            with self.lock:
+                taken = task.copies or task.done or task not in job.queue
+                if not taken:
+                    job.queue.remove(task)
+                    task.done = True
+                    job.delivering += 1
+            if taken:
+                os.remove(output)
+                continue
+            self.deliver("cache", task, output)
+            hits += 1
+        print(f"Result cache: {hits} hits out of {len(queued)} tasks of job {job.id}")
+
+    def run(self, until_idle=True):
+        """Hand out work until every job is finished, or forever when serving as a daemon."""
+        while not (until_idle and self.is_done()):
+            now = time.time()
+            self.finish_jobs()
+
+            # Offer worker slots to the fastest nodes first
+            live_nodes = get_live_nodes()
+            self.reclaim_lost(live_nodes)
+            with self.lock:
+                queues = [job.queue for job in sorted(self.active_jobs(), key=lambda job: job.pass_value) if job.queue]
+                head = queues[0][0] if queues else None
+            if head is not None:
+                order = sorted(live_nodes, key=lambda ip: get_node_model(ip).estimate(head))
+            else:
+                order = list(live_nodes)
+
+            for ip_address in order:
+                node_info = live_nodes[ip_address]
+                worker = self.workers.get(ip_address)
+                if worker is not None and worker.is_alive():
+                    continue
+                if self.retry_at.get(ip_address, 0) > now:
+                    continue
+
+                # Don't start more workers than there is work for or concurrency allows
+                with self.lock:
+                    running = sum(1 for w in self.workers.values() if w.is_alive())
+                    if running >= self.max_workers:
+                        break
+                if not self.has_work():
+                    break
+
+                worker = threading.Thread(target=self.worker, args=(ip_address, node_info["status"]), daemon=True)
+                self.workers[ip_address] = worker
+                worker.start()
+
+            # Wait for a short interval before polling again to avoid busy-waiting
+            time.sleep(POLL_INTERVAL)
+
+def manage_task_submission(job, result_store, max_workers=MAX_CONCURRENCY, task_timeline=None):
+    """Assign the tasks of a job to available nodes until the job is finished.
+
+    Nodes are taken from the live membership table, so nodes that boot mid-run
+    pick up work as soon as their first beacon arrives.
+    """
+    dispatcher = Dispatcher(result_store, max_workers, task_timeline)
+    dispatcher.add_job(job)
+    dispatcher.run()
+
+def parse_range(text):
+    """Parse a "START:END" range, raises ValueError if it isn't one."""
+    try:
+        task_range = tuple(int(v) for v in text.split(":"))
+    except ValueError:
+        task_range = ()
+    if len(task_range) != 2:
+        raise ValueError("--range expects START:END")
+    return task_range
+
+def submit_job(dispatcher, spec, result_cache=None):
+    """Build a job from a submission to the daemon's job API and hand it to the dispatcher.
+
+    `spec` holds the command line options of the job (see submission_from_args).
+    Raises ValueError for an invalid submission.
+    """
+    job_id = spec.get("job_id")
+    with dispatcher.lock:
+        previous = dispatcher.jobs.get(job_id)
+        if previous is not None and previous.finished is None:
+            raise ValueError(f"Job {job_id} is still running.")
+    name = job_id or uuid.uuid4().hex[:8]
+
+    # Jobs run side by side, so a concatenation without a file name gets one per job
+    reduce_spec = spec.get("reduce")
+    if reduce_spec == "concat":
+        reduce_spec = f"concat:reduced_{name}.txt"
+    reduce_stage = make_reduce_stage(reduce_spec)
+
+    task_range = parse_range(spec["range"]) if spec.get("range") else None
+    if not spec.get("binary"):
+        raise ValueError("A job needs a binary.")
+    if spec.get("priority", 1) <= 0:
+        raise ValueError("The priority must be positive.")
+    job = build_job(name, spec["binary"], spec.get("payloads", []), spec.get("arguments", []), spec.get("shard"),
+                    spec.get("shards", 0), spec.get("record_size", 0), spec.get("overlap", 0), reduce_stage,
+                    task_range, spec.get("min_chunk", 1), spec.get("range_format", RANGE_FORMAT),
+                    spec.get("batch", 0), bool(job_id), result_cache if spec.get("cache") else None,
+                    spec.get("priority", 1))
+    dispatcher.add_job(job)
+    return job
+
+class DaemonHandler(http.server.BaseHTTPRequestHandler):
+    """Job API of the commander daemon.
+
+      POST   /jobs                   submit a job, JSON with the job's command line options
+      GET    /jobs                   progress of every job
+      GET    /jobs/<id>              progress of a job, with the reduced result once it is finished
+      GET    /jobs/<id>/results      index of the job's results streamed row by row, ?argument= and ?node= filter it
+      GET    /jobs/<id>/results/<n>  output of the result at position n
+      GET    /jobs/<id>/export       every output of the job in one tar stream
+      DELETE /jobs/<id>              cancel a job, its running tasks finish and are kept
+      GET    /nodes                  live nodes and what was learned about their speed
+      GET    /trace                  timeline of all tasks as a Chrome trace (daemon started with --trace)
+      GET    /trace/summary          time per phase, bytes moved and idle time per node
+
+    Results are served from the result store, so they stay available after the job
+    has finished and for jobs of earlier runs.
+    """
+    def send_json(self, code, body):
+        data = json.dumps(body, indent=1).encode()
+        self.send_response(code)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+
+    def send_json_rows(self, rows):
+        """Stream `rows` as a JSON array one row at a time, the response ends when the connection closes."""
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json")
+        self.end_headers()
+        separator = b"[\n"
+        for row in rows:
+            self.wfile.write(separator + json.dumps(row).encode())
+            separator = b",\n"
+        self.wfile.write(b"[]\n" if separator == b"[\n" else b"\n]\n")
+
+    def find_job(self, job_id):
+        job = self.server.dispatcher.jobs.get(job_id)
+        if job is None:
+            self.send_json(404, {"error": f"No job {job_id}"})
+        return job
+
+    def do_GET(self):
+        dispatcher = self.server.dispatcher
+        url = urllib.parse.urlsplit(self.path)
+        query = dict(urllib.parse.parse_qsl(url.query))
+        parts = [urllib.parse.unquote(part) for part in url.path.split("/") if part]
+        if parts == ["jobs"]:
+            self.send_json(200, [dispatcher.job_status(job) for job in list(dispatcher.jobs.values())])
+        elif parts == ["nodes"]:
+            nodes = {}
+            for ip, info in get_live_nodes().items():
+                model = get_node_model(ip)
+                nodes[ip] = dict(info, upload_bps=model.upload_rate(), seconds_per_work=model.seconds_per_work,
+                                 completed=model.completed)
+            self.send_json(200, nodes)
+        elif parts in (["trace"], ["trace", "summary"]):
+            if dispatcher.timeline is None:
+                self.send_json(404, {"error": "The daemon was started without --trace"})
+            elif parts == ["trace"]:
+                self.send_json(200, dispatcher.timeline.chrome_trace())
+            else:
+                self.send_json(200, dispatcher.timeline.summary())
+        elif len(parts) == 2 and parts[0] == "jobs":
+            job = self.find_job(parts[1])
+            if job is not None:
+                self.send_json(200, dispatcher.job_status(job))
+        elif len(parts) == 3 and parts[0] == "jobs" and parts[2] == "results":
+            self.send_json_rows(dispatcher.store.query(parts[1], query.get("argument"), query.get("node")))
+        elif len(parts) == 4 and parts[0] == "jobs" and parts[2] == "results":
+            self.send_result(parts[1], parts[3])
+        elif len(parts) == 3 and parts[0] == "jobs" and parts[2] == "export":
+            self.send_response(200)
+            self.send_header("Content-Type", "application/x-tar")
+            self.end_headers()
+            dispatcher.store.export(parts[1], self.wfile)
+        else:
+            self.send_json(404, {"error": "Unknown endpoint"})
+
+    def send_result(self, job_id, position):
+        row = self.server.dispatcher.store.get(job_id, int(position)) if position.isdigit() else None
+        if row is None or not os.path.exists(row["path"]):
+            self.send_json(404, {"error": f"No result {position} in job {job_id}"})
+            return
+        self.send_response(200)
+        self.send_header("Content-Type", "application/octet-stream")
+        self.send_header("Content-Length", str(row["size"]))
+        self.end_headers()
+        with open(row["path"], "rb") as f:
+            shutil.copyfileobj(f, self.wfile)
+
+    def do_POST(self):
+        if self.path.rstrip("/") != "/jobs":
+            self.send_json(404, {"error": "Unknown endpoint"})
+            return
+        try:
+            spec = json.loads(self.rfile.read(int(self.headers.get("Content-Length", 0))))
+            job = submit_job(self.server.dispatcher, spec, self.server.result_cache)
+        except (ValueError, KeyError, TypeError) as e:
+            self.send_json(400, {"error": str(e)})
+            return
+        self.send_json(201, self.server.dispatcher.job_status(job))
+
+    def do_DELETE(self):
+        parts = [part for part in self.path.split("/") if part]
+        if len(parts) != 2 or parts[0] != "jobs":
+            self.send_json(404, {"error": "Unknown endpoint"})
+            return
+        job = self.find_job(parts[1])
+        if job is None:
+            return
+        with self.server.dispatcher.lock:
+            if job.finished is None:
+                job.cancel()
+        self.send_json(200, self.server.dispatcher.job_status(job))
+
+def run_daemon(result_store, port=DAEMON_PORT, max_workers=MAX_CONCURRENCY, result_cache=None, trace_path=None):
+    """Serve jobs submitted to the job API until interrupted.
+
+    Membership, node sessions, node models and the result cache stay warm between
+    jobs, all jobs share the nodes through one dispatcher and keep their outputs in
+    one result store. With a trace path, the timeline of all jobs is written there on exit.
+    """
+    server = http.server.ThreadingHTTPServer((DAEMON_HOST, port), DaemonHandler)
+    task_timeline = timeline.Timeline() if trace_path else None
+    discovery_start = time.time()
+    stop_event = wait_for_nodes()
+    if task_timeline:
+        task_timeline.span("discovery", discovery_start, time.time())
+    dispatcher = Dispatcher(result_store, max_workers, task_timeline)
+    server.dispatcher = dispatcher
+    server.result_cache = result_cache
+    threading.Thread(target=dispatcher.run, args=(False,), daemon=True).start()
+
+    print(f"Accepting jobs on http://{DAEMON_HOST}:{port}/jobs")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        print("Stopping, journaled jobs continue when submitted again with the same job id")
+    server.server_close()
+    stop_event.set()
+    if task_timeline:
+        task_timeline.write(trace_path)
+        print(task_timeline.report())
+
+def submission_from_args(args):
+    """The job given on the command line, as submitted to the daemon. Paths are made absolute."""
+    spec = {"binary": [os.path.abspath(path) for path in args.binary],
+            "payloads": [os.path.abspath(path) for path in args.payloads],
+            "arguments": args.arguments,
+            "priority": args.priority}
+    if args.shard:
+        spec.update(shard=os.path.abspath(args.shard), shards=args.shards, record_size=args.record_size,
+                    overlap=args.overlap)
+    if args.range:
+        spec.update(range=args.range, min_chunk=args.min_chunk, range_format=args.range_format)
+    if args.batch:
+        spec["batch"] = args.batch
+    if args.reduce:
+        spec["reduce"] = args.reduce
+    if args.job_id:
+        spec["job_id"] = args.job_id
+    if args.cache:
+        spec["cache"] = True
+    return spec
+
+def daemon_request(port, method, path, body=None):
+    """Call the daemon's job API, returns the decoded JSON answer or None if the daemon isn't running."""
+    try:
+        response = requests.request(method, f"http://{DAEMON_HOST}:{port}{path}", json=body, timeout=REQUEST_TIMEOUT)
+    except requests.RequestException as e:
+        print(f"Error reaching the daemon on port {port}: {e}")
+        return None
+    answer = response.json()
+    if response.status_code >= 400:
+        print(f"Error: {answer.get('error')}")
+        return None
+    return answer
+
+def retrieve_outputs(result_store):
+    """Retrieve task outputs from available nodes, kept in the result store as job "retrieved"."""
     print("Listening for node broadcasts...")
     listen_for_nodes()
 
@@ -299,12 +1741,163 @@ def retrieve_outputs():
         node_url = f"http://{ip_address}"
 
         # Check for task output
-        output = get_task_output(node_url)
+        output = get_task_output(node_url, result_store.incoming("retrieved"))
         if output:
+            output = result_store.add("retrieved", result_store.next_position("retrieved"), output, node=ip_address)
             print(f"Output from {node_url}: {output}")
         else:
             print(f"No output available yet from {node_url}")
 
+def trace_span(events, name):
+    """Seconds between the last begin and end events of `name` in a node trace, None if there is no such pair."""
+    begin, span = None, None
+    for time_us, event, phase, _ in events:
+        if event != name:
+            continue
+        if phase == "B":
+            begin = time_us
+        elif phase == "E" and begin is not None:
+            span = (time_us - begin) / 1e6
+            begin = None
+    return span
+
+def bench_run(ip_address, binary, name, count, payload=None):
+    """Run one benchmark of tessie_bench on a node, returns (run seconds, load seconds, phases) or None.
+
+    The times come from the node's trace. For nodes without one the run is the time from /execute to the
+    output, which includes the loader and a round trip, and the load is None.
+    """
+    node_url = f"http://{ip_address}"
+    task = Task(binary_data=binary, payload_files=[payload] if payload else None, argument=f"{name} {count}")
+    phases = {}
+    if not submit_task(node_url, task, phases, binary):
+        return None
+    try:
+        if fetch_task_output(node_url, TASK_TIMEOUT, os.devnull, phases) is None:
+            print(f"Benchmark {name} left no output on {ip_address}")
+            return None
+        trace = fetch_node_trace(node_url)
+    except (requests.RequestException, ValueError) as e:
+        print(f"Error running benchmark {name} on {ip_address}: {e}")
+        return None
+    if trace is not None:
+        run, execute = trace_span(trace["events"], "run"), trace_span(trace["events"], "execute")
+        if run is not None and execute is not None:
+            return run, execute - run, phases
+    return phases["run"][1] - phases["execute"][0], None, phases
+
+def bench_node(ip_address, info, binary, repeat):
+    """Run every benchmark on a node, scaled to take at least BENCH_MIN_SECONDS, returns its rates or None.
+
+    Rates are per second (operations, bytes or lines), "load" is the loader's seconds and "upload" the
+    bandwidth of the payload upload in bytes per second.
+    """
+    node_url = f"http://{ip_address}"
+    try:
+        fetch_node_trace(node_url)  # Start from an empty trace buffer
+    except (requests.RequestException, ValueError):
+        pass
+
+    # SPIFFS writes are limited to half of the free space
+    free = info.get("free_spiffs_bytes")
+    free = free if isinstance(free, int) else DEFAULT_SHARD_BYTES
+    limits = {"spiffs_w": max(free // 2 // 1024, 1), "stdio": max(free // 2 // 16, 1)}
+    payload = BytesPayload("bench", bytes(range(256)) * (BENCH_PAYLOAD_BYTES // 256))
+
+    rates, baseline = {}, 0.0
+    for name, count, work in BENCHMARKS:
+        limit = min(limits.get(name, BENCH_MAX_COUNT), BENCH_MAX_COUNT)
+        count = min(count, limit)
+        samples = []
+        while len(samples) < repeat:
+            result = bench_run(ip_address, binary, name, count, payload if name == "spiffs_r" else None)
+            if result is None:
+                return None
+            seconds, load, phases = result
+            if load is None:
+                seconds = max(seconds - baseline, 1e-6)  # Without a trace, take off what the empty task took
+            if name != "empty" and not samples and seconds < BENCH_MIN_SECONDS and count < limit:
+                # Too short to time well, scale up and start over
+                count = min(limit, count * min(max(2, math.ceil(BENCH_MIN_SECONDS * 1.5 / max(seconds, 1e-4))), 1000))
+                continue
+            samples.append((seconds, load, phases))
+
+        best = min(samples, key=lambda sample: sample[0])
+        if name == "empty":
+            loads = [load for _, load, _ in samples if load is not None]
+            rates["load"] = min(loads) if loads else best[0]
+            baseline = best[0] if not loads else 0.0
+        else:
+            rates[name] = count * work / max(best[0], 1e-6)
+        if name == "spiffs_r":
+            rates["upload"] = max(payload.length / (p["payload"][1] - p["payload"][0]) for _, _, p in samples)
+        print(f"Benchmark {name} on {ip_address}: {count} iterations, best of {repeat} runs {best[0]:.3f}s")
+    return rates
+
+def format_rate(name, rate):
+    unit, scale, _ = profiles.METRICS[name]
+    value = rate * scale
+    return f"{value:.1f}" if value < 1000 else f"{value:.0f}"
+
+def run_bench(binary_files, repeat=BENCH_REPEAT):
+    """Benchmark every live node with a build of tessie_bench, save the profiles and report degraded nodes."""
+    builds = read_builds(binary_files)
+    wait_for_nodes()
+    live_nodes = get_live_nodes()
+    targets = {ip: info for ip, info in live_nodes.items() if info.get("arch", DEFAULT_ARCH) in builds or None in builds}
+    for ip in sorted(set(live_nodes) - set(targets)):
+        print(f"No build for node {ip} ({live_nodes[ip].get('arch', DEFAULT_ARCH)}), skipping it")
+    if not targets:
+        print("No nodes to benchmark.")
+        return
+
+    # Nodes run their benchmarks in parallel, one at a time on each node
+    results = {}
+    def worker(ip, info):
+        arch = info.get("arch", DEFAULT_ARCH)
+        results[ip] = bench_node(ip, info, builds.get(arch, builds.get(None)), repeat)
+    threads = [threading.Thread(target=worker, args=(ip, info)) for ip, info in targets.items()]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+
+    names = list(profiles.METRICS)
+    print("\n" + f"{'node':<16} {'arch':<8} " + " ".join(f"{name:>9}" for name in names))
+    print(f"{'':<16} {'':<8} " + " ".join(f"{profiles.METRICS[name][0]:>9}" for name in names))
+    measured = {}
+    for ip in sorted(results):
+        info, rates = targets[ip], results[ip]
+        if rates is None:
+            print(f"{ip:<16} benchmark failed")
+            continue
+        arch = info.get("arch", DEFAULT_ARCH)
+        PROFILE_STORE.add(info.get("mac", ip), info.get("node_name"), arch, rates)
+        get_node_model(ip).apply_profile(rates)
+        measured[ip] = (arch, rates)
+        print(f"{ip:<16} {arch:<8} " + " ".join(f"{format_rate(name, rates[name]) if name in rates else '-':>9}" for name in names))
+
+    # Degraded nodes: slower than their own earlier runs, or than the other nodes of their architecture
+    print()
+    reported = False
+    for ip, (arch, rates) in sorted(measured.items()):
+        reasons = []
+        history = PROFILE_STORE.history_median(targets[ip].get("mac", ip))
+        if history:
+            reasons += [f"{name} at {share:.0%} of its earlier runs" for name, share in profiles.compare(rates, history).items()]
+        peers = [other for other_ip, (other_arch, other) in measured.items() if other_arch == arch]
+        if len(peers) >= 3:
+            median = profiles.median_rates(peers)
+            # Upload bandwidth depends on each node's signal, only its own history tells it degraded
+            median.pop("upload", None)
+            reasons += [f"{name} at {share:.0%} of the {arch} median" for name, share in profiles.compare(rates, median).items()]
+        if reasons:
+            reported = True
+            print(f"Degraded: {ip}: " + ", ".join(reasons))
+    if not reported:
+        print("No degraded nodes.")
+    print(f"Profiles saved in {PROFILE_STORE.directory}")
+
 if __name__ == "__main__":
     # Enriching the description with more details and examples
     parser = argparse.ArgumentParser(
@@ -336,6 +1929,55 @@ Examples of usage:
 
 8. Submit a task with multiple payloads, each with a different argument:
    python3 tessie.py -b task.elf -f logfile1.csv logfile2.csv -a "A" "B"
+
+9. Split a large line-delimited file into shards, repeating 3 samples across shard boundaries:
+   python3 tessie.py -b tessie_chaos.elf -s samples.txt --overlap 3
+
+10. Sum the partial results of a range split task as they arrive:
+   python3 tessie.py -b tessie_mpi.elf -a "0:1000000" "1000000:2000000" --reduce sum
+
+11. Split a range into chunks sized to node speed on the fly, and sum the results:
+   python3 tessie.py -b tessie_mpi.elf --range 0:100000000 --min-chunk 100000 --reduce sum
+
+12. Pack many small items into batches of 500 per execution, collecting results in item order:
+   python3 tessie.py -b tessie_batch.elf -a "AA:BB:CC:DD:EE:FF" "11:22:33:44:55:66" ... --batch 500 --reduce concat
+
+13. Journal a long job, rerun the same command after a crash to continue where it stopped:
+   python3 tessie.py -b tessie_chaos.elf -s samples.txt --overlap 3 -j chaos_run1
+
+14. Reuse outputs of tasks already run in an earlier, overlapping sweep:
+   python3 tessie.py -b tessie_mpi.elf -a "0:1000" "1000:2000" "2000:3000" --cache --reduce sum
+
+15. Invalidate the result cache:
+   python3 tessie.py --cache-clear
+
+16. Trace where the time of a job goes, for Perfetto or chrome://tracing:
+   python3 tessie.py -b tessie_chaos.elf -s samples.txt --overlap 3 --trace chaos.json
+
+17. List the results a job produced for one argument:
+   python3 tessie.py --results chaos_run1 -a "AA:BB:CC:DD:EE:FF"
+
+18. Export every output of a job into one tar archive:
+   python3 tessie.py --export chaos_run1 chaos_run1.tar
+
+19. Keep the commander running as a daemon that accepts jobs on a local API:
+   python3 tessie.py --daemon --cache
+
+20. Submit a job to the daemon at twice the priority of other jobs, then follow its progress:
+   python3 tessie.py -b tessie_mpi.elf --range 0:100000000 --reduce sum --submit --priority 2
+   python3 tessie.py --jobs 1a2b3c4d
+
+21. Run a job on ESP32 and Linux nodes alike, each node gets the build for its architecture:
+   python3 tessie.py -b tessie_mpi.elf tessie_mpi.o --range 0:100000000 --reduce sum
+
+22. Send a CSV dataset as binary columns, and turn the task's columnar output back into CSV:
+   python3 tessie.py --to-columns samples.csv samples.tscl --column-types dff
+   python3 tessie.py -b tessie_columns.elf -f samples.tscl -j stats
+   python3 tessie.py --results stats
+   python3 tessie.py --from-columns tessie_results/stats-4b5af442/0/0 stats.csv
+
+23. Benchmark every node, saving its performance profile for the scheduler and reporting degraded nodes:
+   python3 tessie.py --bench -b tessie_bench.elf ../Node/Linux/tasks/tessie_bench.o
 """,
         formatter_class=argparse.RawTextHelpFormatter  # Ensures text formatting is preserved
     )
@@ -343,8 +1985,9 @@ Examples of usage:
     # Mandatory binary file (e.g., task.bin)
     parser.add_argument(
         "-b", "--binary", 
-        type=str, 
-        help="Path to the binary file to submit (e.g., task.elf).", 
+        nargs='+', 
+        help="Path to the binary file to submit (e.g., task.elf). Give builds for several node architectures\n"
+             "(e.g., task.elf task_x86_64.o) to run on each node the build matching its beacon's arch.", 
         required=False
     )
 
@@ -378,14 +2021,313 @@ Examples of usage:
         help="Only listen for nodes and report their status."
     )
 
+    # Sharding of one large input file
+    parser.add_argument(
+        "-s", "--shard",
+        type=str,
+        help="Split one large input file into record-aligned shards, one task per shard."
+    )
+
+    parser.add_argument(
+        "--shards",
+        type=int,
+        default=0,
+        help="Number of shards (default: sized to the nodes' free SPIFFS, at least %d per node)." % SHARDS_PER_NODE
+    )
+
+    parser.add_argument(
+        "--record-size",
+        type=int,
+        default=0,
+        help="Size of fixed-width binary records in bytes (default: 0, line-delimited text)."
+    )
+
+    parser.add_argument(
+        "--overlap",
+        type=int,
+        default=0,
+        help="Number of preceding records repeated at the start of every shard for window-based tasks."
+    )
+
+    # Adaptive range partitioning
+    parser.add_argument(
+        "--range",
+        type=str,
+        help="Split an integer range START:END into chunk arguments on demand, large chunks first."
+    )
+
+    parser.add_argument(
+        "--min-chunk",
+        type=int,
+        default=1,
+        help="Smallest chunk a range is split into (default 1)."
+    )
+
+    parser.add_argument(
+        "--range-format",
+        type=str,
+        default=RANGE_FORMAT,
+        help=f"Argument generated for every chunk (default \"{RANGE_FORMAT}\")."
+    )
+
+    # Micro-batching
+    parser.add_argument(
+        "--batch",
+        type=int,
+        default=0,
+        help="Pack this many -a items into one execution, for tasks built with tessie_batch.h."
+    )
+
+    # Result cache
+    parser.add_argument(
+        "--cache",
+        action="store_true",
+        help="Reuse outputs of tasks already run with the same binary, payload and argument."
+    )
+
+    parser.add_argument(
+        "--cache-dir",
+        type=str,
+        default=CACHE_DIR,
+        help=f"Directory of the result cache (default {CACHE_DIR})."
+    )
+
+    parser.add_argument(
+        "--cache-max-mb",
+        type=int,
+        default=CACHE_MAX_MB,
+        help=f"Size limit of the result cache, least recently used outputs are evicted (default {CACHE_MAX_MB})."
+    )
+
+    parser.add_argument(
+        "--cache-clear",
+        action="store_true",
+        help="Invalidate every entry of the result cache."
+    )
+
+    # Crash-safe resume
+    parser.add_argument(
+        "-j", "--job-id",
+        type=str,
+        help=f"Journal the job under this id in {JOURNAL_DIR}/; rerunning with the same id skips completed tasks."
+    )
+
+    # Reduce stage
+    parser.add_argument(
+        "--reduce",
+        type=str,
+        help="Combine outputs as they arrive: sum, min, max, hist[:key prefix], concat[:file], topk[:k] or plugin.py[:param]."
+    )
+
+    # Waiting time for task output
+    parser.add_argument(
+        "--task-timeout",
+        type=int,
+        default=TASK_TIMEOUT,
+        help=f"Seconds to wait for a task to finish before requeuing it (default {TASK_TIMEOUT})."
+    )
+
+    # Bounded concurrency
+    parser.add_argument(
+        "--max-concurrency",
+        type=int,
+        default=MAX_CONCURRENCY,
+        help=f"Maximum number of tasks running on the cluster at once (default {MAX_CONCURRENCY})."
+    )
+
+    # Timeline tracing
+    parser.add_argument(
+        "--trace",
+        type=str,
+        metavar="FILE",
+        help="Record the phases of every task, write them as a Chrome/Perfetto trace and print a summary."
+    )
+
+    # Result store
+    parser.add_argument(
+        "--results-dir",
+        type=str,
+        default=RESULTS_DIR,
+        help=f"Directory of the result store, outputs indexed by job, task, argument and node (default {RESULTS_DIR})."
+    )
+
+    parser.add_argument(
+        "--results",
+        type=str,
+        metavar="JOB_ID",
+        help="List the results of a job from the result store, only those of the -a arguments if given."
+    )
+
+    parser.add_argument(
+        "--export",
+        nargs=2,
+        metavar=("JOB_ID", "FILE"),
+        help="Write every output of a job to one tar archive (- for stdout)."
+    )
+
+    # Daemon mode
+    parser.add_argument(
+        "--daemon",
+        action="store_true",
+        help=f"Keep running and accept jobs from the local job API on {DAEMON_HOST}."
+    )
+
+    parser.add_argument(
+        "--daemon-port",
+        type=int,
+        default=DAEMON_PORT,
+        help=f"Port of the daemon's job API (default {DAEMON_PORT})."
+    )
+
+    parser.add_argument(
+        "--submit",
+        action="store_true",
+        help="Submit the job given with -b to the daemon instead of running it here."
+    )
+
+    parser.add_argument(
+        "--priority",
+        type=float,
+        default=1,
+        help="Share of the nodes a submitted job gets relative to other jobs of the daemon (default 1)."
+    )
+
+    parser.add_argument(
+        "--jobs",
+        nargs="?",
+        const="",
+        help="Show the progress of the daemon's jobs, or of one job with its reduced result."
+    )
+
+    parser.add_argument(
+        "--cancel",
+        type=str,
+        help="Cancel a job of the daemon."
+    )
+
+    # Columnar payloads
+    parser.add_argument(
+        "--to-columns",
+        nargs=2,
+        metavar=("CSV", "FILE"),
+        help="Convert a CSV file to a columnar payload for tasks built with tessie_columns.h."
+    )
+
+    parser.add_argument(
+        "--column-types",
+        type=str,
+        default="",
+        help="Types of the leading columns for --to-columns, one letter each: i int32, q int64, f float, d double\n"
+             "(default: inferred, i or q for integers and d for the rest)."
+    )
+
+    parser.add_argument(
+        "--from-columns",
+        nargs=2,
+        metavar=("FILE", "CSV"),
+        help="Convert a columnar file, e.g. a task output, back to CSV."
+    )
+
+    # Benchmarks and node profiles
+    parser.add_argument(
+        "--bench",
+        action="store_true",
+        help="Run the benchmarks of the tessie_bench builds given with -b on every node and save their profiles."
+    )
+
+    parser.add_argument(
+        "--bench-repeat",
+        type=int,
+        default=BENCH_REPEAT,
+        help=f"Runs of every benchmark, the fastest counts (default {BENCH_REPEAT})."
+    )
+
+    parser.add_argument(
+        "--profiles-dir",
+        type=str,
+        default=PROFILES_DIR,
+        help=f"Directory of the node performance profiles the scheduler starts from (default {PROFILES_DIR})."
+    )
+
     args = parser.parse_args()
+    TASK_TIMEOUT = args.task_timeout
+    PROFILE_STORE = profiles.ProfileStore(args.profiles_dir)
+
+    result_cache = None
+    if args.cache or args.cache_clear or args.daemon:
+        result_cache = cache.ResultCache(args.cache_dir, args.cache_max_mb * 1024 * 1024)
+
+    result_store = None
+    if (args.binary and not args.submit and not args.bench) or args.daemon or args.retrieve or args.results or args.export:
+        result_store = results.ResultStore(args.results_dir)
+
+    task_range = None
+    if args.range:
+        try:
+            task_range = parse_range(args.range)
+        except ValueError as e:
+            parser.error(str(e))
 
     # Check if we are only listening for nodes
-    if args.listen:
+    if args.cache_clear:
+        print(f"Removed {result_cache.clear()} entries from the result cache")
+    elif args.listen:
         manage_nodes()
+    elif args.to_columns:
+        csv_path, columns_path = args.to_columns
+        try:
+            rows, count, size = columns.csv_to_columns(csv_path, columns_path, args.column_types)
+        except (OSError, ValueError) as e:
+            parser.error(str(e))
+        text_size = os.path.getsize(csv_path)
+        print(f"Wrote {rows} rows of {count} columns to {columns_path}: {size} bytes, "
+              f"{text_size / max(size, 1):.1f}x smaller than {csv_path}")
+    elif args.from_columns:
+        columns_path, csv_path = args.from_columns
+        try:
+            rows, count = columns.columns_to_csv(columns_path, csv_path)
+        except (OSError, ValueError) as e:
+            parser.error(str(e))
+        print(f"Wrote {rows} rows of {count} columns to {csv_path}")
+    elif args.daemon:
+        run_daemon(result_store, args.daemon_port, args.max_concurrency, result_cache, args.trace)
+    elif args.results:
+        print("position\ttask\targument\tnode\tsize\tpath")
+        for argument in args.arguments or [None]:
+            for row in result_store.query(args.results, argument):
+                print(f"{row['position']}\t{row['task']}\t{row['argument']}\t{row['node']}\t{row['size']}\t{row['path']}")
+    elif args.export:
+        job_id, export_path = args.export
+        if export_path == "-":
+            result_store.export(job_id, sys.stdout.buffer)
+        else:
+            with open(export_path, "wb") as f:
+                print(f"Exported {result_store.export(job_id, f)} results of job {job_id} to {export_path}")
+    elif args.jobs is not None:
+        answer = daemon_request(args.daemon_port, "GET", f"/jobs/{args.jobs}" if args.jobs else "/jobs")
+        if answer is not None:
+            print(json.dumps(answer, indent=1))
+    elif args.cancel:
+        answer = daemon_request(args.daemon_port, "DELETE", f"/jobs/{args.cancel}")
+        if answer is not None:
+            print(f"Job {answer['id']} {answer['state']}")
+    elif args.bench:
+        if not args.binary:
+            parser.error("--bench needs the builds of tessie_bench, give them with -b.")
+        try:
+            run_bench(args.binary, max(args.bench_repeat, 1))
+        except ValueError as e:
+            parser.error(str(e))
+    elif args.binary and args.submit:
+        answer = daemon_request(args.daemon_port, "POST", "/jobs", submission_from_args(args))
+        if answer is not None:
+            print(f"Submitted job {answer['id']}, {answer['queued']} tasks queued")
     elif args.binary:
-        queue_tasks(args.binary, args.payloads, args.arguments)
+        queue_tasks(args.binary, args.payloads, args.arguments, args.max_concurrency,
+                    args.shard, args.shards, args.record_size, args.overlap, args.reduce,
+                    task_range, args.min_chunk, args.range_format, args.batch, args.job_id,
+                    result_cache, result_store, args.trace)
     elif args.retrieve:
-        retrieve_outputs()
+        retrieve_outputs(result_store)
     else:
         print("No valid options provided. Use -b for submitting tasks, -r for retrieving outputs, or -l for listening to nodes.")
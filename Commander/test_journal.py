@@ -0,0 +1,59 @@
+# Tesselator commander - job journal tests
+# https://github.com/invpe/Tesselator
+#
+#   python3 -m unittest test_journal
+import json
+import os
+import tempfile
+import unittest
+
+import journal
+
+class TornRecordTest(unittest.TestCase):
+    def setUp(self):
+        handle, self.path = tempfile.mkstemp(suffix=".journal")
+        os.close(handle)
+
+    def tearDown(self):
+        os.remove(self.path)
+
+    def write_crashed_journal(self, tail):
+        first = journal.Journal(self.path)
+        first.start("abc")
+        first.define(0, {"argument": "A"})
+        first.define(1, {"argument": "B"})
+        first.complete(0, "10.0.0.1", "out0")
+        first.close()
+        with open(self.path, "a") as f:
+            f.write(tail)  # What a crash in the middle of a write leaves behind
+
+    def test_record_after_torn_line_survives_replay(self):
+        self.write_crashed_journal('{"type": "assign", "ta')
+
+        resumed = journal.Journal(self.path)
+        self.assertEqual(set(resumed.completed), {0})
+        resumed.complete(1, "10.0.0.2", "out1")
+        resumed.close()
+
+        replayed = journal.Journal(self.path)
+        replayed.close()
+        self.assertEqual(set(replayed.completed), {0, 1})
+        self.assertEqual(replayed.completed[1]["output"], "out1")
+        with open(self.path) as f:
+            for line in f:
+                json.loads(line)  # No fragment is left in the file
+
+    def test_record_without_newline_is_dropped(self):
+        self.write_crashed_journal(json.dumps({"type": "complete", "id": 1, "node": "10.0.0.2", "output": "out1"}))
+
+        resumed = journal.Journal(self.path)
+        resumed.fail(1, "10.0.0.2")
+        resumed.close()
+
+        replayed = journal.Journal(self.path)
+        replayed.close()
+        self.assertEqual(set(replayed.completed), {0})
+        self.assertEqual(replayed.binary_sha256, "abc")
+
+if __name__ == "__main__":
+    unittest.main()
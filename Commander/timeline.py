@@ -0,0 +1,188 @@
+# Tesselator commander - task timeline
+# https://github.com/invpe/Tesselator
+#
+# Records where the wall-clock time of a job goes: node discovery and, for every task,
+# the time it waited in the queue, each upload step, the /execute call, the run on the
+# node (until /output answers), the output download and the hand-off to the result store
+# and reducer. The timeline exports to the Chrome trace format (open it in Perfetto or
+# chrome://tracing) and summarises into a report: time per phase, bytes moved, busy and
+# idle time per node, and the critical path of the node that finished last.
+#
+# Nodes that record their own events (see Node/ESP32/trace.h) add what happens inside
+# them: SPIFFS writes, reading and relocating the ELF, the task run and the output
+# stream, shifted onto the commander's clock by the offset measured through /clock.
+import json
+import threading
+import time
+
+# Task phases in the order they happen, as recorded by the dispatcher
+PHASES = ("queued", "binary", "payload", "arg", "execute", "run", "download", "deliver")
+
+class Timeline:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.origin = time.time()
+        self.spans = []  # (name, lane, start, end, args) of commander wide spans, e.g. discovery
+        self.tasks = []  # One record per task copy run on a node
+        self.node_side = []  # (node, name, phase, time, value) of events recorded by the nodes, on our clock
+
+    def span(self, name, start, end, lane="commander", **args):
+        with self.lock:
+            self.spans.append((name, lane, start, end, args))
+
+    def task(self, node, label, assigned, finished, phases, bytes_up=0, bytes_down=0, outcome="completed"):
+        """Record a task copy run on `node`; `phases` maps phase names to (start, end) times."""
+        record = {"node": node, "label": label, "assigned": assigned, "finished": finished, "outcome": outcome,
+                  "phases": dict(phases), "bytes_up": bytes_up, "bytes_down": bytes_down}
+        with self.lock:
+            self.tasks.append(record)
+
+    def node_events(self, node, events, offset):
+        """Add events drained from a node's /trace, [time_us, name, phase, value] on the node's clock."""
+        with self.lock:
+            for time_us, name, phase, value in events:
+                self.node_side.append((node, name, phase, offset + time_us / 1e6, value))
+
+    def node_spans(self):
+        """Begin and end events of the nodes paired into (node, name, start, end, value) spans."""
+        with self.lock:
+            events = sorted(self.node_side, key=lambda event: event[3])
+        spans, open_spans = [], {}
+        for node, name, phase, when, value in events:
+            if phase == "B":
+                open_spans[node, name] = when  # A begin without an end, e.g. a failed load, is replaced
+            elif phase == "E" and (node, name) in open_spans:
+                spans.append((node, name, open_spans.pop((node, name)), when, value))
+        return spans
+
+    def chrome_trace(self):
+        """The timeline in the Chrome trace event format, times in microseconds since the timeline started."""
+        def us(t):
+            return round((t - self.origin) * 1e6)
+
+        with self.lock:
+            spans, tasks = list(self.spans), list(self.tasks)
+        lanes = ["commander"] + sorted({record["node"] for record in tasks} | {lane for _, lane, _, _, _ in spans} - {"commander"})
+        tid = {lane: index for index, lane in enumerate(lanes)}
+
+        events = [{"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "Tesselator"}}]
+        for lane, index in tid.items():
+            events.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": index, "args": {"name": lane}})
+        for name, lane, start, end, args in spans:
+            events.append({"name": name, "cat": "commander", "ph": "X", "pid": 1, "tid": tid[lane],
+                           "ts": us(start), "dur": us(end) - us(start), "args": args})
+        for record in tasks:
+            lane = tid[record["node"]]
+            events.append({"name": record["label"], "cat": "task", "ph": "X", "pid": 1, "tid": lane,
+                           "ts": us(record["assigned"]), "dur": us(record["finished"]) - us(record["assigned"]),
+                           "args": {"outcome": record["outcome"], "bytes_up": record["bytes_up"],
+                                    "bytes_down": record["bytes_down"]}})
+            for phase, (start, end) in sorted(record["phases"].items(), key=lambda item: item[1][0]):
+                if phase not in PHASES or phase == "queued" or end is None:
+                    continue  # Queue time lies before the task reached the node
+                events.append({"name": phase, "cat": "phase", "ph": "X", "pid": 1, "tid": lane,
+                               "ts": us(start), "dur": us(end) - us(start)})
+
+        # What the nodes recorded themselves, in a process of its own below the commander's view
+        with self.lock:
+            node_side = list(self.node_side)
+        if node_side:
+            nodes = {node: index for index, node in enumerate(sorted({event[0] for event in node_side}))}
+            events.append({"name": "process_name", "ph": "M", "pid": 2, "args": {"name": "Node side"}})
+            for node, index in nodes.items():
+                events.append({"name": "thread_name", "ph": "M", "pid": 2, "tid": index, "args": {"name": node}})
+            for node, name, start, end, value in self.node_spans():
+                events.append({"name": name, "cat": "node", "ph": "X", "pid": 2, "tid": nodes[node],
+                               "ts": us(start), "dur": us(end) - us(start), "args": {"value": value}})
+            for node, name, phase, when, value in node_side:
+                if phase == "I":
+                    events.append({"name": name, "cat": "node", "ph": "i", "s": "t", "pid": 2, "tid": nodes[node],
+                                   "ts": us(when), "args": {"value": value}})
+        return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+    def write(self, path):
+        with open(path, "w") as f:
+            json.dump(self.chrome_trace(), f)
+
+    def summary(self):
+        """Time per phase, bytes moved, per node busy and idle time and the critical path, as a dict."""
+        with self.lock:
+            tasks = list(self.tasks)
+        if not tasks:
+            return {"tasks": 0}
+
+        window_start = min(record["assigned"] for record in tasks)
+        window_end = max(record["finished"] for record in tasks)
+        makespan = max(window_end - window_start, 1e-9)
+
+        phases = {phase: 0.0 for phase in PHASES}
+        for record in tasks:
+            for phase, (start, end) in record["phases"].items():
+                if phase in phases and end is not None:
+                    phases[phase] += end - start
+
+        nodes = {}
+        for record in sorted(tasks, key=lambda record: record["assigned"]):
+            node = nodes.setdefault(record["node"], {"tasks": 0, "busy": 0.0, "bytes_up": 0, "bytes_down": 0,
+                                                     "failed": 0, "duplicates": 0, "last_end": None, "records": []})
+            node["tasks"] += 1
+            node["bytes_up"] += record["bytes_up"]
+            node["bytes_down"] += record["bytes_down"]
+            node["failed"] += record["outcome"] == "failed"
+            node["duplicates"] += record["outcome"] == "duplicate"
+            # Union of task intervals, a re-attached task may overlap the next one
+            start = record["assigned"] if node["last_end"] is None else max(record["assigned"], node["last_end"])
+            node["busy"] += max(record["finished"] - start, 0.0)
+            node["last_end"] = max(node["last_end"] or 0.0, record["finished"])
+            node["records"].append(record)
+        for node in nodes.values():
+            node["idle_percent"] = 100.0 * (1.0 - node["busy"] / makespan)
+
+        # The node that finished last sets the makespan; its tasks and the gaps between them are the critical path
+        last_ip = max(nodes, key=lambda ip: nodes[ip]["last_end"])
+        last = nodes[last_ip]
+        path_phases = {phase: 0.0 for phase in PHASES if phase != "queued"}
+        for record in last["records"]:
+            for phase, (start, end) in record["phases"].items():
+                if phase in path_phases and end is not None:
+                    path_phases[phase] += end - start
+        critical = {"node": last_ip, "tasks": last["tasks"], "busy": last["busy"],
+                    "idle": (last["last_end"] - window_start) - last["busy"],
+                    "last_task": last["records"][-1]["label"], "phases": path_phases}
+
+        node_phases = {}
+        for _, name, start, end, _ in self.node_spans():
+            node_phases[name] = node_phases.get(name, 0.0) + end - start
+
+        return {"tasks": len(tasks), "nodes": len(nodes), "makespan": makespan, "phases": phases,
+                "bytes_up": sum(node["bytes_up"] for node in nodes.values()),
+                "bytes_down": sum(node["bytes_down"] for node in nodes.values()),
+                "per_node": {ip: {key: value for key, value in node.items() if key not in ("records", "last_end")}
+                             for ip, node in nodes.items()},
+                "critical_path": critical, "node_phases": node_phases}
+
+    def report(self):
+        summary = self.summary()
+        if not summary["tasks"]:
+            return "No tasks were traced"
+
+        phases = dict(summary["phases"])
+        queued = phases.pop("queued")
+        total = sum(phases.values()) or 1e-9
+        lines = [f"Timeline of {summary['tasks']} task runs on {summary['nodes']} nodes, makespan {summary['makespan']:.2f} s",
+                 f"Tasks waited {queued:.2f} s in the queue in total, time per phase on the nodes, summed over tasks:"]
+        for phase, seconds in phases.items():
+            lines.append(f"  {phase:<10} {seconds:10.2f} s {100.0 * seconds / total:5.1f}%")
+        lines.append(f"Bytes moved: {summary['bytes_up']} to nodes, {summary['bytes_down']} from nodes")
+        lines.append(f"  {'node':<16} {'tasks':>5} {'busy s':>9} {'idle %':>7} {'bytes up':>11} {'bytes down':>11}")
+        for ip, node in sorted(summary["per_node"].items()):
+            lines.append(f"  {ip:<16} {node['tasks']:>5} {node['busy']:>9.2f} {node['idle_percent']:>7.1f} "
+                         f"{node['bytes_up']:>11} {node['bytes_down']:>11}")
+        critical = summary["critical_path"]
+        phases = ", ".join(f"{phase} {seconds:.2f} s" for phase, seconds in critical["phases"].items() if seconds)
+        lines.append(f"Critical path: {critical['node']} finished last after {critical['tasks']} tasks, "
+                     f"{critical['busy']:.2f} s busy and {critical['idle']:.2f} s idle; {phases}")
+        if summary["node_phases"]:
+            lines.append("Inside the nodes: " + ", ".join(f"{name} {seconds:.2f} s" for name, seconds
+                                                          in sorted(summary["node_phases"].items(), key=lambda item: -item[1])))
+        return "\n".join(lines)
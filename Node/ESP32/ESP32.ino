@@ -8,6 +8,7 @@
 #include <ArduinoOTA.h>
 #include "SPIFFS.h"
 #include "loader.h"
+#include "trace.h"
 
 #define WIFI_SSID "COMPUTING"
 #define WIFI_PASS "TESSIE1911COMP"
@@ -48,8 +49,10 @@ unsigned char* LoadELFFile(const char* path, size_t* file_size) {
   }
 
   // Read the binary file into the buffer
+  traceEvent("elf_read", TRACE_BEGIN, *file_size);
   file.read(buffer, *file_size);
   file.close();
+  traceEvent("elf_read", TRACE_END, *file_size);
 
   // Return the binary data
   return buffer;
@@ -70,10 +73,10 @@ void BroadcastTimer(void* param) {
   // Get the current RSSI
   int32_t rssi = WiFi.RSSI();
 
-  // Manually construct the JSON string with MAC address, task count, status, free SPIFFS space, and RSSI
+  // Manually construct the JSON string with MAC address, task count, status, free SPIFFS space, RSSI and architecture
   String strAnnouncement = "{\"node\":\"TESSIE_NODE\",\"mac\":\"" + macAddress + "\",\"total_executed\":"
                            + String(uiTotalExecuted) + ",\"status\":\"" + status + "\",\"free_spiffs_bytes\":"
-                           + String(freeBytes) + ",\"rssi\":" + String(rssi) + "}";
+                           + String(freeBytes) + ",\"rssi\":" + String(rssi) + ",\"arch\":\"" LOADER_ARCH "\"}";
 
   udp.beginPacket("255.255.255.255", UDP_PORT);  // Broadcast message to the entire network
   udp.write((uint8_t*)strAnnouncement.c_str(), strAnnouncement.length());
@@ -150,6 +153,7 @@ void setup() {
 
     // Mark busy from now
     bBusy = true;
+    traceEvent("execute", TRACE_BEGIN, 0);
 
     // Cleanup
     SPIFFS.remove(OUTPUT_FILE);
@@ -160,6 +164,7 @@ void setup() {
 
     if (!main_elf) {
       WWWServer.send(500, "application/json", "{\"status\": \"error\", \"message\": \"Failed to load ELF binary\"}");
+      traceEvent("execute", TRACE_END, 1);
       bBusy = false;
       return;
     }
@@ -176,7 +181,11 @@ void setup() {
       { "fseek", (void*)fseek },
       { "ftell", (void*)ftell },
       { "fflush", (void*)fflush },
-      { "fscanf", (void*)fscanf }
+      { "fscanf", (void*)fscanf },
+      // Emitted by the compiler for printf and fprintf of plain strings
+      { "fputs", (void*)fputs },
+      { "fputc", (void*)fputc },
+      { "putchar", (void*)putchar }
     };
 
     double a = log2(2);
@@ -186,6 +195,7 @@ void setup() {
     if (!ctx) {
       WWWServer.send(500, "application/json", "{\"status\": \"error\", \"message\": \"Failed to load ELF binary\"}");
       free(main_elf);
+      traceEvent("execute", TRACE_END, 1);
       bBusy = false;
       return;
     }
@@ -195,6 +205,7 @@ void setup() {
       WWWServer.send(500, "application/json", "{\"status\": \"error\", \"message\": \"Failed to set function\"}");
       elfLoaderFree(ctx);
       free(main_elf);
+      traceEvent("execute", TRACE_END, 1);
       bBusy = false;
       return;
     }
@@ -205,7 +216,9 @@ void setup() {
     // Execute the function
     typedef void (*func_t)(const char*, size_t len);
     func_t func = (func_t)ctx->exec;
+    traceEvent("run", TRACE_BEGIN, strArgument.length());
     func(strArgument.c_str(), strArgument.length());
+    traceEvent("run", TRACE_END, 0);
 
     // Increment total executed tasks
     uiTotalExecuted++;
@@ -215,6 +228,7 @@ void setup() {
     free(main_elf);
 
     // Mark as not busy
+    traceEvent("execute", TRACE_END, 0);
     bBusy = false;
   });
 
@@ -228,6 +242,7 @@ void setup() {
       HTTPUpload& upload = WWWServer.upload();
 
       if (upload.status == UPLOAD_FILE_START) {
+        traceEvent("binary_write", TRACE_BEGIN, 0);
         SPIFFS.remove(BINARY_FILE);
         Serial.println("Binary upload started: " + upload.filename);
         binaryFile = SPIFFS.open(BINARY_FILE, FILE_WRITE);
@@ -241,9 +256,12 @@ void setup() {
         binaryFile.write(upload.buf, upload.currentSize);
       } else if (upload.status == UPLOAD_FILE_END) {
         binaryFile.close();
+        traceEvent("binary_write", TRACE_END, upload.totalSize);
         Serial.println("Binary upload complete");
         WWWServer.send(200, "application/json", "{\"status\": \"success\", \"message\": \"Binary upload complete\"}");
       } else {
+        // Aborted after the start, close its span
+        traceEvent("binary_write", TRACE_END, 0);
         Serial.println("Error during binary upload");
         WWWServer.send(500, "application/json", "{\"status\": \"error\", \"message\": \"Binary upload error\"}");
       }
@@ -261,6 +279,7 @@ void setup() {
 
 
       if (upload.status == UPLOAD_FILE_START) {
+        traceEvent("payload_write", TRACE_BEGIN, 0);
         SPIFFS.remove(INPUT_FILE);
         Serial.println("Payload upload started: " + upload.filename);
         payloadFile = SPIFFS.open(INPUT_FILE, FILE_WRITE);
@@ -276,9 +295,12 @@ void setup() {
       } else if (upload.status == UPLOAD_FILE_END) {
         // Close the file when upload ends
         payloadFile.close();
+        traceEvent("payload_write", TRACE_END, upload.totalSize);
         Serial.println("Payload upload complete");
         WWWServer.send(200, "application/json", "{\"status\": \"success\", \"message\": \"Payload upload complete\"}");
       } else {
+        // Aborted after the start, close its span
+        traceEvent("payload_write", TRACE_END, 0);
         Serial.println("Error during payload upload");
         WWWServer.send(500, "application/json", "{\"status\": \"error\", \"message\": \"Payload upload error\"}");
       }
@@ -293,8 +315,10 @@ void setup() {
       return;
     }
 
+    traceEvent("output", TRACE_BEGIN, outputFile.size());
     WWWServer.streamFile(outputFile, "application/octet-stream");
     outputFile.close();
+    traceEvent("output", TRACE_END, 0);
   });
 
   // Return if busy or available
@@ -312,11 +336,37 @@ void setup() {
       WWWServer.send(200, "application/json", "{\"status\": \"busy\"}");
     } else {
       strArgument = WWWServer.arg("plain");  // Store the argument
+      traceEvent("arg", TRACE_INSTANT, strArgument.length());
       Serial.println("Argument received: " + strArgument);
       WWWServer.send(200, "application/json", "{\"status\": \"ok\", \"argument\": \"" + strArgument + "\"}");
     }
   });
 
+  // Node clock for the commander to align trace events with, microseconds since boot
+  WWWServer.on("/clock", [&]() {
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "{\"now\": %lld}", (long long)traceNow());
+    WWWServer.send(200, "application/json", buffer);
+  });
+
+  // Drain the trace ring buffer, oldest event first
+  WWWServer.on("/trace", [&]() {
+    char buffer[96];
+    WWWServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    WWWServer.send(200, "application/json", "");
+
+    snprintf(buffer, sizeof(buffer), "{\"now\": %lld, \"dropped\": %u, \"events\": [", (long long)traceNow(), (unsigned)traceDropped());
+    WWWServer.sendContent(buffer);
+    for (size_t n = 0; n < traceCount(); n++) {
+      const TraceEvent_t* event = traceAt(n);
+      snprintf(buffer, sizeof(buffer), "%s[%lld, \"%s\", \"%c\", %u]", n ? ", " : "", (long long)event->time, event->name, event->phase, (unsigned)event->value);
+      WWWServer.sendContent(buffer);
+    }
+    WWWServer.sendContent("]}");
+    WWWServer.sendContent("");
+    traceClear();
+  });
+
   // Init HTTP
   WWWServer.begin();
 
@@ -224,6 +224,7 @@ typedef struct {
 #define EM_ARC_A5	93		/* ARC Cores Tangent-A5 */
 #define EM_XTENSA	94		/* Tensilica Xtensa Architecture */
 #define EM_NUM		95
+#define EM_RISCV	243		/* RISC-V */
 
 /* Legal values for e_version (version).  */
 
@@ -1203,5 +1204,58 @@ typedef struct {
 #define R_XTENSA_SLOT13_ALT	48
 #define R_XTENSA_SLOT14_ALT	49
 
+/* AMD x86-64 relocations, https://gitlab.com/x86-psABIs/x86-64-ABI */
+
+#define R_X86_64_NONE		0	/* No reloc */
+#define R_X86_64_64		1	/* Direct 64 bit  */
+#define R_X86_64_PC32		2	/* PC relative 32 bit signed */
+#define R_X86_64_GOT32		3	/* 32 bit GOT entry */
+#define R_X86_64_PLT32		4	/* 32 bit PLT address */
+#define R_X86_64_GOTPCREL	9	/* 32 bit signed PC relative offset to GOT */
+#define R_X86_64_32		10	/* Direct 32 bit zero extended */
+#define R_X86_64_32S		11	/* Direct 32 bit sign extended */
+#define R_X86_64_16		12	/* Direct 16 bit zero extended */
+#define R_X86_64_PC16		13	/* 16 bit sign extended pc relative */
+#define R_X86_64_8		14	/* Direct 8 bit sign extended  */
+#define R_X86_64_PC8		15	/* 8 bit sign extended pc relative */
+#define R_X86_64_PC64		24	/* PC relative 64 bit */
+#define R_X86_64_GOTPCRELX	41	/* Load from 32 bit signed pc relative offset to GOT entry without REX prefix, relaxable */
+#define R_X86_64_REX_GOTPCRELX	42	/* Load from 32 bit signed pc relative offset to GOT entry with REX prefix, relaxable */
+
+/* RISC-V relocations, https://github.com/riscv-non-isa/riscv-elf-psabi-doc */
+
+#define R_RISCV_NONE		0	/* No reloc */
+#define R_RISCV_32		1	/* Direct 32 bit */
+#define R_RISCV_64		2	/* Direct 64 bit */
+#define R_RISCV_BRANCH		16	/* 12 bit PC relative branch offset, B-type */
+#define R_RISCV_JAL		17	/* 20 bit PC relative jump offset, J-type */
+#define R_RISCV_CALL		18	/* 32 bit PC relative call, AUIPC and JALR pair */
+#define R_RISCV_CALL_PLT	19	/* 32 bit PC relative call through the PLT, AUIPC and JALR pair */
+#define R_RISCV_GOT_HI20	20	/* High 20 bits of 32 bit PC relative GOT entry address */
+#define R_RISCV_PCREL_HI20	23	/* High 20 bits of 32 bit PC relative address */
+#define R_RISCV_PCREL_LO12_I	24	/* Low 12 bits of the PCREL_HI20 at the symbol, I-type */
+#define R_RISCV_PCREL_LO12_S	25	/* Low 12 bits of the PCREL_HI20 at the symbol, S-type */
+#define R_RISCV_HI20		26	/* High 20 bits of 32 bit absolute address */
+#define R_RISCV_LO12_I		27	/* Low 12 bits of 32 bit absolute address, I-type */
+#define R_RISCV_LO12_S		28	/* Low 12 bits of 32 bit absolute address, S-type */
+#define R_RISCV_ADD8		33	/* 8 bit label addition */
+#define R_RISCV_ADD16		34	/* 16 bit label addition */
+#define R_RISCV_ADD32		35	/* 32 bit label addition */
+#define R_RISCV_ADD64		36	/* 64 bit label addition */
+#define R_RISCV_SUB8		37	/* 8 bit label subtraction */
+#define R_RISCV_SUB16		38	/* 16 bit label subtraction */
+#define R_RISCV_SUB32		39	/* 32 bit label subtraction */
+#define R_RISCV_SUB64		40	/* 64 bit label subtraction */
+#define R_RISCV_ALIGN		43	/* Alignment padding a relaxing linker may shrink */
+#define R_RISCV_RVC_BRANCH	44	/* 8 bit PC relative branch offset, CB-type */
+#define R_RISCV_RVC_JUMP	45	/* 11 bit PC relative jump offset, CJ-type */
+#define R_RISCV_RELAX		51	/* The instruction pair may be relaxed */
+#define R_RISCV_SUB6		52	/* Low 6 bits label subtraction */
+#define R_RISCV_SET6		53	/* Low 6 bits label set */
+#define R_RISCV_SET8		54	/* 8 bit label set */
+#define R_RISCV_SET16		55	/* 16 bit label set */
+#define R_RISCV_SET32		56	/* 32 bit label set */
+#define R_RISCV_32_PCREL	57	/* 32 bit PC relative */
+
 
 #endif	/* elf.h */
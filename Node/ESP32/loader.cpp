@@ -1,6 +1,18 @@
 #include "loader.h"
+#include "trace.h"
 
 
+#ifdef __linux
+void* loaderMap(size_t size) {
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_32BIT
+  flags |= MAP_32BIT;
+#endif
+  void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+  return data == MAP_FAILED ? NULL : data;
+}
+#endif
+
 uint8_t unalignedGet8(void* src) {
   uintptr_t csrc = (uintptr_t)src;
   uint32_t v = *(uint32_t*)(csrc & 0xfffffffc);
@@ -50,9 +62,9 @@ void unalignedCpy(void* dest, void* src, size_t n) {
     n--;
   }
 }
-int readSection(ELFLoaderContext_t* ctx, int n, Elf32_Shdr* h, char* name, size_t name_len) {
-  off_t offset = ctx->e_shoff + n * sizeof(Elf32_Shdr);
-  LOADER_GETDATA(ctx, offset, h, sizeof(Elf32_Shdr));
+int readSection(ELFLoaderContext_t* ctx, int n, Elf_Shdr* h, char* name, size_t name_len) {
+  off_t offset = ctx->e_shoff + n * sizeof(Elf_Shdr);
+  LOADER_GETDATA(ctx, offset, h, sizeof(Elf_Shdr));
 
   if (h->sh_name) {
     offset = ctx->shstrtab_offset + h->sh_name;
@@ -60,14 +72,14 @@ int readSection(ELFLoaderContext_t* ctx, int n, Elf32_Shdr* h, char* name, size_
   }
   return 0;
 }
-int readSymbol(ELFLoaderContext_t* ctx, int n, Elf32_Sym* sym, char* name, size_t nlen) {
-  off_t pos = ctx->symtab_offset + n * sizeof(Elf32_Sym);
-  LOADER_GETDATA(ctx, pos, sym, sizeof(Elf32_Sym))
+int readSymbol(ELFLoaderContext_t* ctx, int n, Elf_Sym* sym, char* name, size_t nlen) {
+  off_t pos = ctx->symtab_offset + n * sizeof(Elf_Sym);
+  LOADER_GETDATA(ctx, pos, sym, sizeof(Elf_Sym))
   if (sym->st_name) {
     off_t offset = ctx->strtab_offset + sym->st_name;
     LOADER_GETDATA(ctx, offset, name, nlen);
   } else {
-    Elf32_Shdr shdr;
+    Elf_Shdr shdr;
     return readSection(ctx, sym->st_shndx, &shdr, name, nlen);
   }
   return 0;
@@ -81,9 +93,60 @@ err:
 /*** Relocation functions ***/
 
 
-const char* type2String(int symt) {
+const char* type2String(int machine, int symt) {
 #define STRCASE(name) \
   case name: return #name;
+  if (machine == EM_X86_64) {
+    switch (symt) {
+      STRCASE(R_X86_64_NONE)
+      STRCASE(R_X86_64_64)
+      STRCASE(R_X86_64_PC32)
+      STRCASE(R_X86_64_PLT32)
+      STRCASE(R_X86_64_GOTPCREL)
+      STRCASE(R_X86_64_32)
+      STRCASE(R_X86_64_32S)
+      STRCASE(R_X86_64_PC64)
+      STRCASE(R_X86_64_GOTPCRELX)
+      STRCASE(R_X86_64_REX_GOTPCRELX)
+      default:
+        return "R_<unknow>";
+    }
+  }
+  if (machine == EM_RISCV) {
+    switch (symt) {
+      STRCASE(R_RISCV_NONE)
+      STRCASE(R_RISCV_32)
+      STRCASE(R_RISCV_BRANCH)
+      STRCASE(R_RISCV_JAL)
+      STRCASE(R_RISCV_CALL)
+      STRCASE(R_RISCV_CALL_PLT)
+      STRCASE(R_RISCV_GOT_HI20)
+      STRCASE(R_RISCV_PCREL_HI20)
+      STRCASE(R_RISCV_PCREL_LO12_I)
+      STRCASE(R_RISCV_PCREL_LO12_S)
+      STRCASE(R_RISCV_HI20)
+      STRCASE(R_RISCV_LO12_I)
+      STRCASE(R_RISCV_LO12_S)
+      STRCASE(R_RISCV_ADD8)
+      STRCASE(R_RISCV_ADD16)
+      STRCASE(R_RISCV_ADD32)
+      STRCASE(R_RISCV_SUB8)
+      STRCASE(R_RISCV_SUB16)
+      STRCASE(R_RISCV_SUB32)
+      STRCASE(R_RISCV_ALIGN)
+      STRCASE(R_RISCV_RVC_BRANCH)
+      STRCASE(R_RISCV_RVC_JUMP)
+      STRCASE(R_RISCV_RELAX)
+      STRCASE(R_RISCV_SUB6)
+      STRCASE(R_RISCV_SET6)
+      STRCASE(R_RISCV_SET8)
+      STRCASE(R_RISCV_SET16)
+      STRCASE(R_RISCV_SET32)
+      STRCASE(R_RISCV_32_PCREL)
+      default:
+        return "R_<unknow>";
+    }
+  }
   switch (symt) {
     STRCASE(R_XTENSA_NONE)
     STRCASE(R_XTENSA_32)
@@ -96,8 +159,8 @@ const char* type2String(int symt) {
 }
 
 
-int relocateSymbol(Elf32_Addr relAddr, int type, Elf32_Addr symAddr, Elf32_Addr defAddr, uint32_t* from, uint32_t* to) {
-  if (symAddr == 0xffffffff) {
+int relocateSymbol(Elf_Addr relAddr, int type, Elf_Addr symAddr, Elf_Addr defAddr, uint32_t* from, uint32_t* to) {
+  if (symAddr == LOADER_NO_SYMBOL) {
     if (defAddr == 0x00000000) {
       return -1;
     } else {
@@ -221,6 +284,286 @@ int relocateSymbol(Elf32_Addr relAddr, int type, Elf32_Addr symAddr, Elf32_Addr
 }
 
 
+/* x86-64: a jump stub within 32 bit reach of the sections, for calls to a symbol further away */
+static Elf_Addr stubFor(ELFLoaderContext_t* ctx, Elf_Addr target) {
+  for (size_t n = 0; n < ctx->stub_count; n++) {
+    uint8_t* stub = ctx->stubs + n * LOADER_STUB_SIZE;
+    if (memcmp(stub + 6, &target, sizeof(target)) == 0) {
+      return (Elf_Addr)(uintptr_t)stub;
+    }
+  }
+  if (ctx->stub_count >= ctx->symtab_count) {
+    return LOADER_NO_SYMBOL;
+  }
+  uint8_t* stub = ctx->stubs + ctx->stub_count++ * LOADER_STUB_SIZE;
+  static const uint8_t jump[6] = { 0xff, 0x25, 0x00, 0x00, 0x00, 0x00 }; /* jmp *0(%rip) */
+  memcpy(stub, jump, sizeof(jump));
+  memcpy(stub + 6, &target, sizeof(target));
+  return (Elf_Addr)(uintptr_t)stub;
+}
+
+/* Room for a stub (x86-64 only) and a GOT slot per symbol, allocated with the sections so it is in reach of them */
+static int allocStubs(ELFLoaderContext_t* ctx, size_t stubSize) {
+  if (ctx->stubs) {
+    return 0;
+  }
+  ctx->stubs_size = ctx->symtab_count * (stubSize + sizeof(Elf_Addr));
+  ctx->stubs = (uint8_t*)(stubSize ? LOADER_ALLOC_EXEC(ctx->stubs_size) : LOADER_ALLOC_DATA(ctx->stubs_size));
+  if (!ctx->stubs) {
+    return -1;
+  }
+  ctx->got = (Elf_Addr*)(ctx->stubs + ctx->symtab_count * stubSize);
+  return 0;
+}
+
+/* The GOT slot holding a symbol's address */
+static Elf_Addr gotFor(ELFLoaderContext_t* ctx, Elf_Addr target) {
+  for (size_t n = 0; n < ctx->got_count; n++) {
+    if (ctx->got[n] == target) {
+      return (Elf_Addr)(uintptr_t)&ctx->got[n];
+    }
+  }
+  if (ctx->got_count >= ctx->symtab_count) {
+    return LOADER_NO_SYMBOL;
+  }
+  ctx->got[ctx->got_count] = target;
+  return (Elf_Addr)(uintptr_t)&ctx->got[ctx->got_count++];
+}
+
+static int fitsInt32(int64_t v) {
+  return v >= INT32_MIN && v <= INT32_MAX;
+}
+
+int relocateSymbolX86_64(ELFLoaderContext_t* ctx, Elf_Addr relAddr, int type, Elf_Addr symAddr, int64_t addend) {
+  if (allocStubs(ctx, LOADER_STUB_SIZE) != 0) {
+    return -1;
+  }
+
+  switch (type) {
+    case R_X86_64_NONE:
+      break;
+    case R_X86_64_64:
+    case R_X86_64_PC64:
+      {
+        uint64_t v = symAddr + addend - (type == R_X86_64_PC64 ? relAddr : 0);
+        memcpy((void*)relAddr, &v, sizeof(v));
+        break;
+      }
+    case R_X86_64_PC32:
+    case R_X86_64_PLT32:
+      {
+        int64_t v = (int64_t)(symAddr + addend - relAddr);
+        if (!fitsInt32(v)) {
+          /* Exported functions live far away in the host's libraries, go through a stub */
+          Elf_Addr stub = stubFor(ctx, symAddr);
+          if (stub == LOADER_NO_SYMBOL) {
+            return -1;
+          }
+          v = (int64_t)(stub + addend - relAddr);
+        }
+        if (!fitsInt32(v)) {
+          return -1;
+        }
+        int32_t v32 = (int32_t)v;
+        memcpy((void*)relAddr, &v32, sizeof(v32));
+        break;
+      }
+    case R_X86_64_GOTPCREL:
+    case R_X86_64_GOTPCRELX:
+    case R_X86_64_REX_GOTPCRELX:
+      {
+        Elf_Addr slot = gotFor(ctx, symAddr);
+        int64_t v = (int64_t)(slot + addend - relAddr);
+        if (slot == LOADER_NO_SYMBOL || !fitsInt32(v)) {
+          return -1;
+        }
+        int32_t v32 = (int32_t)v;
+        memcpy((void*)relAddr, &v32, sizeof(v32));
+        break;
+      }
+    case R_X86_64_32:
+    case R_X86_64_32S:
+      {
+        uint64_t v = symAddr + addend;
+        if (type == R_X86_64_32 ? v > UINT32_MAX : !fitsInt32((int64_t)v)) {
+          return -1;
+        }
+        uint32_t v32 = (uint32_t)v;
+        memcpy((void*)relAddr, &v32, sizeof(v32));
+        break;
+      }
+    default:
+      return -1;
+  }
+  return 0;
+}
+
+
+/* RISC-V: instructions are 2 byte aligned with the C extension, so they are read and written piecewise */
+static uint16_t unalignedGet16(void* src) {
+  uintptr_t csrc = (uintptr_t)src;
+  return unalignedGet8((void*)csrc) | (unalignedGet8((void*)(csrc + 1)) << 8);
+}
+
+static void unalignedSet16(void* dest, uint16_t value) {
+  uintptr_t cdest = (uintptr_t)dest;
+  unalignedSet8((void*)cdest, value & 0xff);
+  unalignedSet8((void*)(cdest + 1), value >> 8);
+}
+
+static int fitsSigned(int32_t v, int bits) {
+  return v >= -(1 << (bits - 1)) && v < (1 << (bits - 1));
+}
+
+/* Split a 32 bit value into the 20 bit upper part for LUI/AUIPC and the sign extended 12 bit rest */
+static uint32_t hi20(uint32_t v) {
+  return (v + 0x800) & 0xfffff000;
+}
+
+static uint32_t lo12(uint32_t v) {
+  return v - hi20(v);
+}
+
+static uint32_t setItype(uint32_t insn, uint32_t imm) {
+  return (insn & 0x000fffff) | ((imm & 0xfff) << 20);
+}
+
+static uint32_t setStype(uint32_t insn, uint32_t imm) {
+  return (insn & 0x01fff07f) | (((imm >> 5) & 0x7f) << 25) | ((imm & 0x1f) << 7);
+}
+
+/* RISC-V: symAddr is S + A, for PCREL_LO12_* it is the AUIPC's address and hiAddr the target of its PCREL_HI20.
+   Nothing is relaxed, the instruction sequences the compiler emitted stay as they are. */
+int relocateSymbolRISCV(ELFLoaderContext_t* ctx, Elf_Addr relAddr, int type, Elf_Addr symAddr, Elf_Addr hiAddr) {
+  void* at = (void*)(uintptr_t)relAddr;
+  int32_t delta = (int32_t)(symAddr - relAddr);
+  switch (type) {
+    case R_RISCV_NONE:
+    case R_RISCV_RELAX:
+    case R_RISCV_ALIGN:
+      /* Without relaxation the padding NOPs of an alignment stay and are executed, which is harmless */
+      break;
+    case R_RISCV_32:
+      unalignedSet32(at, symAddr);
+      break;
+    case R_RISCV_32_PCREL:
+      unalignedSet32(at, delta);
+      break;
+    case R_RISCV_BRANCH:
+      {
+        if ((delta & 1) || !fitsSigned(delta, 13)) {
+          return -1;
+        }
+        uint32_t insn = unalignedGet32(at) & 0x01fff07f;
+        insn |= ((delta >> 12) & 0x1) << 31 | ((delta >> 5) & 0x3f) << 25 | ((delta >> 1) & 0xf) << 8 | ((delta >> 11) & 0x1) << 7;
+        unalignedSet32(at, insn);
+        break;
+      }
+    case R_RISCV_JAL:
+      {
+        if ((delta & 1) || !fitsSigned(delta, 21)) {
+          return -1;
+        }
+        uint32_t insn = unalignedGet32(at) & 0x00000fff;
+        insn |= ((delta >> 20) & 0x1) << 31 | ((delta >> 1) & 0x3ff) << 21 | ((delta >> 11) & 0x1) << 20 | ((delta >> 12) & 0xff) << 12;
+        unalignedSet32(at, insn);
+        break;
+      }
+    case R_RISCV_CALL:
+    case R_RISCV_CALL_PLT:
+      {
+        /* AUIPC and JALR, together they reach the whole 32 bit address space */
+        void* next = (void*)(uintptr_t)(relAddr + 4);
+        unalignedSet32(at, (unalignedGet32(at) & 0xfff) | hi20(delta));
+        unalignedSet32(next, setItype(unalignedGet32(next), lo12(delta)));
+        break;
+      }
+    case R_RISCV_GOT_HI20:
+    case R_RISCV_PCREL_HI20:
+      unalignedSet32(at, (unalignedGet32(at) & 0xfff) | hi20(delta));
+      break;
+    case R_RISCV_PCREL_LO12_I:
+    case R_RISCV_PCREL_LO12_S:
+      {
+        if (hiAddr == LOADER_NO_SYMBOL) {
+          return -1;
+        }
+        uint32_t lo = lo12(hiAddr - symAddr);
+        uint32_t insn = unalignedGet32(at);
+        unalignedSet32(at, type == R_RISCV_PCREL_LO12_I ? setItype(insn, lo) : setStype(insn, lo));
+        break;
+      }
+    case R_RISCV_HI20:
+      unalignedSet32(at, (unalignedGet32(at) & 0xfff) | hi20(symAddr));
+      break;
+    case R_RISCV_LO12_I:
+      unalignedSet32(at, setItype(unalignedGet32(at), lo12(symAddr)));
+      break;
+    case R_RISCV_LO12_S:
+      unalignedSet32(at, setStype(unalignedGet32(at), lo12(symAddr)));
+      break;
+    case R_RISCV_RVC_BRANCH:
+      {
+        if ((delta & 1) || !fitsSigned(delta, 9)) {
+          return -1;
+        }
+        uint16_t insn = unalignedGet16(at) & 0xe383;
+        insn |= ((delta >> 8) & 0x1) << 12 | ((delta >> 3) & 0x3) << 10 | ((delta >> 6) & 0x3) << 5 | ((delta >> 1) & 0x3) << 3 | ((delta >> 5) & 0x1) << 2;
+        unalignedSet16(at, insn);
+        break;
+      }
+    case R_RISCV_RVC_JUMP:
+      {
+        if ((delta & 1) || !fitsSigned(delta, 12)) {
+          return -1;
+        }
+        uint16_t insn = unalignedGet16(at) & 0xe003;
+        insn |= ((delta >> 11) & 0x1) << 12 | ((delta >> 4) & 0x1) << 11 | ((delta >> 8) & 0x3) << 9 | ((delta >> 10) & 0x1) << 8
+                | ((delta >> 6) & 0x1) << 7 | ((delta >> 7) & 0x1) << 6 | ((delta >> 1) & 0x7) << 3 | ((delta >> 5) & 0x1) << 2;
+        unalignedSet16(at, insn);
+        break;
+      }
+    /* Label arithmetic, e.g. lengths in .eh_frame or jump tables */
+    case R_RISCV_ADD8:
+      unalignedSet8(at, unalignedGet8(at) + symAddr);
+      break;
+    case R_RISCV_ADD16:
+      unalignedSet16(at, unalignedGet16(at) + symAddr);
+      break;
+    case R_RISCV_ADD32:
+      unalignedSet32(at, unalignedGet32(at) + symAddr);
+      break;
+    case R_RISCV_SUB6:
+      unalignedSet8(at, (unalignedGet8(at) & 0xc0) | ((unalignedGet8(at) - symAddr) & 0x3f));
+      break;
+    case R_RISCV_SUB8:
+      unalignedSet8(at, unalignedGet8(at) - symAddr);
+      break;
+    case R_RISCV_SUB16:
+      unalignedSet16(at, unalignedGet16(at) - symAddr);
+      break;
+    case R_RISCV_SUB32:
+      unalignedSet32(at, unalignedGet32(at) - symAddr);
+      break;
+    case R_RISCV_SET6:
+      unalignedSet8(at, (unalignedGet8(at) & 0xc0) | (symAddr & 0x3f));
+      break;
+    case R_RISCV_SET8:
+      unalignedSet8(at, symAddr);
+      break;
+    case R_RISCV_SET16:
+      unalignedSet16(at, symAddr);
+      break;
+    case R_RISCV_SET32:
+      unalignedSet32(at, symAddr);
+      break;
+    default:
+      return -1;
+  }
+  return 0;
+}
+
+
 ELFLoaderSection_t* findSection(ELFLoaderContext_t* ctx, int index) {
   for (ELFLoaderSection_t* section = ctx->section; section != NULL; section = section->next) {
     if (section->secIdx == index) {
@@ -231,22 +574,63 @@ ELFLoaderSection_t* findSection(ELFLoaderContext_t* ctx, int index) {
 }
 
 
-Elf32_Addr findSymAddr(ELFLoaderContext_t* ctx, Elf32_Sym* sym, const char* sName) {
+Elf_Addr findSymAddr(ELFLoaderContext_t* ctx, Elf_Sym* sym, const char* sName) {
   for (int i = 0; i < ctx->env->exported_size; i++) {
     if (strcmp(ctx->env->exported[i].name, sName) == 0) {
-      return (Elf32_Addr)(ctx->env->exported[i].ptr);
+      return (Elf_Addr)(uintptr_t)(ctx->env->exported[i].ptr);
     }
   }
+  if (sym->st_shndx == SHN_ABS) {
+    /* Fixed addresses the build took from a linker script, e.g. the ROM functions of the ESP32-C3 */
+    return sym->st_value;
+  }
   ELFLoaderSection_t* symSec = findSection(ctx, sym->st_shndx);
   if (symSec)
-    return ((Elf32_Addr)symSec->data) + sym->st_value;
-  return 0xffffffff;
+    return ((Elf_Addr)(uintptr_t)symSec->data) + sym->st_value;
+  return LOADER_NO_SYMBOL;
 }
 
 
+/* RISC-V: the address a HI20 relocation points its AUIPC at, a GOT slot for GOT_HI20 */
+static Elf_Addr riscvHiTarget(ELFLoaderContext_t* ctx, int type, Elf_Addr found, Elf_Addr addend) {
+  if (found == LOADER_NO_SYMBOL) {
+    return found;
+  }
+  if (type == R_RISCV_GOT_HI20) {
+    if (allocStubs(ctx, 0) != 0) {
+      return LOADER_NO_SYMBOL;
+    }
+    Elf_Addr slot = gotFor(ctx, found);
+    return slot == LOADER_NO_SYMBOL ? slot : slot + addend;
+  }
+  return found + addend;
+}
+
+/* RISC-V: a PCREL_LO12_* names the AUIPC whose PCREL_HI20 it completes, find that relocation and its target */
+static Elf_Addr riscvPcrelHi(ELFLoaderContext_t* ctx, Elf_Shdr* relHdr, ELFLoaderSection_t* s, Elf_Addr auipc) {
+  Elf_Rela rel;
+  size_t relEntries = relHdr->sh_size / sizeof(rel);
+  for (size_t relCount = 0; relCount < relEntries; relCount++) {
+    LOADER_GETDATA(ctx, relHdr->sh_offset + relCount * (sizeof(rel)), &rel, sizeof(rel))
+    int relType = ELF_R_TYPE(rel.r_info);
+    if ((relType != R_RISCV_PCREL_HI20 && relType != R_RISCV_GOT_HI20) || ((Elf_Addr)(uintptr_t)s->data) + rel.r_offset != auipc) {
+      continue;
+    }
+    Elf_Sym sym;
+    char name[33] = "<unnamed>";
+    readSymbol(ctx, ELF_R_SYM(rel.r_info), &sym, name, sizeof(name));
+    return riscvHiTarget(ctx, relType, findSymAddr(ctx, &sym, name), rel.r_addend);
+  }
+  return LOADER_NO_SYMBOL;
+#ifdef __linux
+err:
+  return LOADER_NO_SYMBOL;
+#endif
+}
+
 int relocateSection(ELFLoaderContext_t* ctx, ELFLoaderSection_t* s) {
   char name[33] = "<unamed>";
-  Elf32_Shdr sectHdr;
+  Elf_Shdr sectHdr;
   if (readSection(ctx, s->relSecIdx, &sectHdr, name, sizeof(name)) != 0) {
     return -1;
   }
@@ -258,25 +642,56 @@ int relocateSection(ELFLoaderContext_t* ctx, ELFLoaderSection_t* s) {
   }
 
   int r = 0;
-  Elf32_Rela rel;
+  Elf_Rela rel;
   size_t relEntries = sectHdr.sh_size / sizeof(rel);
   for (size_t relCount = 0; relCount < relEntries; relCount++) {
     LOADER_GETDATA(ctx, sectHdr.sh_offset + relCount * (sizeof(rel)), &rel, sizeof(rel))
-    Elf32_Sym sym;
+    Elf_Sym sym;
     char name[33] = "<unnamed>";
-    int symEntry = ELF32_R_SYM(rel.r_info);
-    int relType = ELF32_R_TYPE(rel.r_info);
-    Elf32_Addr relAddr = ((Elf32_Addr)s->data) + rel.r_offset;  // data to be updated adress
+    int symEntry = ELF_R_SYM(rel.r_info);
+    int relType = ELF_R_TYPE(rel.r_info);
+    Elf_Addr relAddr = ((Elf_Addr)(uintptr_t)s->data) + rel.r_offset;  // data to be updated adress
     readSymbol(ctx, symEntry, &sym, name, sizeof(name));
-    Elf32_Addr symAddr = findSymAddr(ctx, &sym, name) + rel.r_addend;  // target symbol adress
+    Elf_Addr found = symEntry == 0 ? 0 : findSymAddr(ctx, &sym, name);  // No symbol: the addend is the address
+    Elf_Addr symAddr = found == LOADER_NO_SYMBOL ? found : found + rel.r_addend;  // target symbol adress
     uint32_t from = 0;
     uint32_t to = 0;
-    if (relType == R_XTENSA_NONE || relType == R_XTENSA_ASM_EXPAND) {
-      //            MSG("  %08X %04X %04X %-20s %08X          %08X                    %s + %X", rel.r_offset, symEntry, relType, type2String(relType), relAddr, sym.st_value, name, rel.r_addend);
-    } else if ((symAddr == 0xffffffff) && (sym.st_value == 0x00000000)) {
-      r = -1;
-    } else if (relocateSymbol(relAddr, relType, symAddr, sym.st_value, &from, &to) != 0) {
-      r = -1;
+    switch (ctx->machine) {
+      case EM_X86_64:
+        if (relType != R_X86_64_NONE && found == LOADER_NO_SYMBOL) {
+          printf("Unresolved symbol %s\n", name);
+          r = -1;
+        } else if (relocateSymbolX86_64(ctx, relAddr, relType, found, rel.r_addend) != 0) {
+          printf("Failed relocation %s of %s\n", type2String(ctx->machine, relType), name);
+          r = -1;
+        }
+        break;
+      case EM_RISCV:
+        {
+          Elf_Addr hiAddr = LOADER_NO_SYMBOL;
+          if (relType == R_RISCV_GOT_HI20) {
+            symAddr = riscvHiTarget(ctx, relType, found, rel.r_addend);
+          } else if (relType == R_RISCV_PCREL_LO12_I || relType == R_RISCV_PCREL_LO12_S) {
+            hiAddr = riscvPcrelHi(ctx, &sectHdr, s, symAddr);
+          }
+          if (relType != R_RISCV_NONE && relType != R_RISCV_RELAX && relType != R_RISCV_ALIGN && symAddr == LOADER_NO_SYMBOL) {
+            printf("Unresolved symbol %s\n", name);
+            r = -1;
+          } else if (relocateSymbolRISCV(ctx, relAddr, relType, symAddr, hiAddr) != 0) {
+            printf("Failed relocation %s of %s\n", type2String(ctx->machine, relType), name);
+            r = -1;
+          }
+          break;
+        }
+      default:
+        if (relType == R_XTENSA_NONE || relType == R_XTENSA_ASM_EXPAND) {
+          //            MSG("  %08X %04X %04X %-20s %08X          %08X                    %s + %X", rel.r_offset, symEntry, relType, type2String(relType), relAddr, sym.st_value, name, rel.r_addend);
+        } else if ((symAddr == LOADER_NO_SYMBOL) && (sym.st_value == 0x00000000)) {
+          r = -1;
+        } else if (relocateSymbol(relAddr, relType, symAddr, sym.st_value, &from, &to) != 0) {
+          r = -1;
+        }
+        break;
     }
   }
   return r;
@@ -296,12 +711,15 @@ void elfLoaderFree(ELFLoaderContext_t* ctx) {
     ELFLoaderSection_t* next;
     while (section != NULL) {
       if (section->data) {
-        free(section->data);
+        LOADER_FREE(section->data, section->size);
       }
       next = section->next;
       free(section);
       section = next;
     }
+    if (ctx->stubs) {
+      LOADER_FREE(ctx->stubs, ctx->stubs_size);
+    }
     free(ctx);
   }
 }
@@ -315,20 +733,27 @@ ELFLoaderContext_t* elfLoaderInitLoadAndRelocate(void* fd, const ELFLoaderEnv_t*
   memset(ctx, 0, sizeof(ELFLoaderContext_t));
   ctx->fd = fd;
   ctx->env = env;
+  int loading = 1; /* Inside the "load" trace span, closed on the error path too */
+  traceEvent("load", TRACE_BEGIN, 0);
   {
-    Elf32_Ehdr header;
-    Elf32_Shdr section;
+    Elf_Ehdr header;
+    Elf_Shdr section;
     /* Load the ELF header, located at the start of the buffer. */
-    LOADER_GETDATA(ctx, 0, &header, sizeof(Elf32_Ehdr));
+    LOADER_GETDATA(ctx, 0, &header, sizeof(Elf_Ehdr));
 
-    /* Make sure that we have a correct and compatible ELF header. */
+    /* Make sure that we have a correct and compatible ELF header, built for the machine we run on. */
     char ElfMagic[] = { 0x7f, 'E', 'L', 'F', '\0' };
     if (memcmp(header.e_ident, ElfMagic, strlen(ElfMagic)) != 0) {
       goto err;
     }
+    if (header.e_ident[EI_CLASS] != LOADER_CLASS || header.e_machine != LOADER_MACHINE) {
+      printf("ELF built for machine %d, this node runs %d\n", header.e_machine, LOADER_MACHINE);
+      goto err;
+    }
+    ctx->machine = header.e_machine;
 
     /* Load the section header, get the number of entries of the section header, get a pointer to the actual table of strings */
-    LOADER_GETDATA(ctx, header.e_shoff + header.e_shstrndx * sizeof(Elf32_Shdr), &section, sizeof(Elf32_Shdr));
+    LOADER_GETDATA(ctx, header.e_shoff + header.e_shstrndx * sizeof(Elf_Shdr), &section, sizeof(Elf_Shdr));
     ctx->e_shnum = header.e_shnum;
     ctx->e_shoff = header.e_shoff;
     ctx->shstrtab_offset = section.sh_offset;
@@ -340,7 +765,7 @@ ELFLoaderContext_t* elfLoaderInitLoadAndRelocate(void* fd, const ELFLoaderEnv_t*
         ".strtab": segment points to the actual string names used by the symbol table
         */
     for (int n = 1; n < ctx->e_shnum; n++) {
-      Elf32_Shdr sectHdr;
+      Elf_Shdr sectHdr;
       char name[33] = "<unamed>";
       if (readSection(ctx, n, &sectHdr, name, sizeof(name)) != 0) {
         goto err;
@@ -364,6 +789,7 @@ ELFLoaderContext_t* elfLoaderInitLoadAndRelocate(void* fd, const ELFLoaderEnv_t*
           }
           section->secIdx = n;
           section->size = sectHdr.sh_size;
+          section->exec = (sectHdr.sh_flags & SHF_EXECINSTR) != 0;
           if (sectHdr.sh_type != SHT_NOBITS) {
             LOADER_GETDATA(ctx, sectHdr.sh_offset, section->data, sectHdr.sh_size);
           } else {
@@ -385,7 +811,7 @@ ELFLoaderContext_t* elfLoaderInitLoadAndRelocate(void* fd, const ELFLoaderEnv_t*
       } else {
         if (strcmp(name, ".symtab") == 0) {
           ctx->symtab_offset = sectHdr.sh_offset;
-          ctx->symtab_count = sectHdr.sh_size / sizeof(Elf32_Sym);
+          ctx->symtab_count = sectHdr.sh_size / sizeof(Elf_Sym);
         } else if (strcmp(name, ".strtab") == 0) {
           ctx->strtab_offset = sectHdr.sh_offset;
         }
@@ -396,18 +822,38 @@ ELFLoaderContext_t* elfLoaderInitLoadAndRelocate(void* fd, const ELFLoaderEnv_t*
     }
   }
 
+  loading = 0;
+  traceEvent("load", TRACE_END, ctx->e_shnum);
+
   {
     int r = 0;
+    traceEvent("relocate", TRACE_BEGIN, 0);
     for (ELFLoaderSection_t* section = ctx->section; section != NULL; section = section->next) {
       r |= relocateSection(ctx, section);
     }
+    traceEvent("relocate", TRACE_END, r != 0);
     if (r != 0) {
       goto err;
     }
   }
+
+#ifdef __linux
+  /* Relocated, the code can drop write access */
+  for (ELFLoaderSection_t* section = ctx->section; section != NULL; section = section->next) {
+    if (section->exec) {
+      mprotect(section->data, section->size, PROT_READ | PROT_EXEC);
+    }
+  }
+  if (ctx->stubs && ctx->machine == EM_X86_64) {
+    mprotect(ctx->stubs, ctx->stubs_size, PROT_READ | PROT_EXEC);
+  }
+#endif
   return ctx;
 
 err:
+  if (loading) {
+    traceEvent("load", TRACE_END, 0);
+  }
   elfLoaderFree(ctx);
   return NULL;
 }
@@ -416,14 +862,14 @@ err:
 int elfLoaderSetFunc(ELFLoaderContext_t* ctx, const char* funcname) {
   ctx->exec = 0;
   for (int symCount = 0; symCount < ctx->symtab_count; symCount++) {
-    Elf32_Sym sym;
+    Elf_Sym sym;
     char name[33] = "<unnamed>";
     if (readSymbol(ctx, symCount, &sym, name, sizeof(name)) != 0) {
       return -1;
     }
     if (strcmp(name, funcname) == 0) {
-      Elf32_Addr symAddr = findSymAddr(ctx, &sym, name);
-      if (symAddr == 0xffffffff) {
+      Elf_Addr symAddr = findSymAddr(ctx, &sym, name);
+      if (symAddr == LOADER_NO_SYMBOL) {
       } else {
         ctx->exec = (void*)symAddr;
       }
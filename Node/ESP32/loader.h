@@ -7,10 +7,55 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <stdint.h> 
+#ifdef __linux
+#include <sys/mman.h>
+#else
 #include "esp_system.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
+#endif
 #include "elf.h"
+
+/* The build decides which objects the loader takes: Xtensa on the ESP32, RISC-V on the ESP32-C3/C6, x86-64 on
+   Linux hosts. A host build may define LOADER_MACHINE itself to load and relocate objects of another 32 bit
+   machine without running them, the sections are mapped in the low 2GB so their addresses fit. */
+#ifndef LOADER_MACHINE
+#if defined(__x86_64__)
+#define LOADER_MACHINE EM_X86_64
+#elif defined(__riscv)
+#define LOADER_MACHINE EM_RISCV
+#else
+#define LOADER_MACHINE EM_XTENSA
+#endif
+#endif
+
+#if LOADER_MACHINE == EM_X86_64
+#define LOADER_CLASS ELFCLASS64
+#define LOADER_ARCH "x86_64"  /* Announced in the beacon, the commander picks builds by it */
+typedef Elf64_Ehdr Elf_Ehdr;
+typedef Elf64_Shdr Elf_Shdr;
+typedef Elf64_Sym Elf_Sym;
+typedef Elf64_Rela Elf_Rela;
+typedef Elf64_Addr Elf_Addr;
+#define ELF_R_SYM(i) ELF64_R_SYM(i)
+#define ELF_R_TYPE(i) ELF64_R_TYPE(i)
+#else
+#define LOADER_CLASS ELFCLASS32
+#if LOADER_MACHINE == EM_RISCV
+#define LOADER_ARCH "riscv"
+#else
+#define LOADER_ARCH "xtensa"
+#endif
+typedef Elf32_Ehdr Elf_Ehdr;
+typedef Elf32_Shdr Elf_Shdr;
+typedef Elf32_Sym Elf_Sym;
+typedef Elf32_Rela Elf_Rela;
+typedef Elf32_Addr Elf_Addr;
+#define ELF_R_SYM(i) ELF32_R_SYM(i)
+#define ELF_R_TYPE(i) ELF32_R_TYPE(i)
+#endif
+
+#define LOADER_NO_SYMBOL ((Elf_Addr)-1) /*!< findSymAddr result for an unresolved symbol */
  
 typedef struct {
   const char* name; /*!< Name of symbol */
@@ -24,15 +69,28 @@ typedef struct {
 
 typedef struct ELFLoaderContext_t ELFLoaderContext_t; 
 
+#ifdef __linux
+#ifndef LOADER_ALLOC_EXEC /* A host build may place the sections itself, see Node/Linux/check */
+/* Sections are mapped in the low 2GB, so they reach each other with 32 bit PC relative and absolute relocations */
+#define LOADER_ALLOC_EXEC(size) loaderMap(size)
+#define LOADER_ALLOC_DATA(size) loaderMap(size)
+#define LOADER_FREE(ptr, size) munmap(ptr, size)
+#endif
+#define LOADER_GETDATA(ctx, off, buffer, size) memcpy(buffer, (char*)ctx->fd + (off), size);
+#else
 #define LOADER_ALLOC_EXEC(size) heap_caps_malloc(size, MALLOC_CAP_EXEC | MALLOC_CAP_32BIT)
 #define LOADER_ALLOC_DATA(size) heap_caps_malloc(size, MALLOC_CAP_8BIT)
+#define LOADER_FREE(ptr, size) free(ptr)
 #define LOADER_GETDATA(ctx, off, buffer, size) unalignedCpy(buffer, ctx->fd + off, size);
+#endif
 
+#define LOADER_STUB_SIZE 16 /*!< x86-64 jump stub: jmp *0(%rip) followed by the 8 byte target */
 
 typedef struct ELFLoaderSection_t {
   void* data;
   int secIdx;
   size_t size;
+  int exec;
   off_t relSecIdx;
   struct ELFLoaderSection_t* next;
 } ELFLoaderSection_t;
@@ -51,6 +109,15 @@ struct ELFLoaderContext_t {
   off_t symtab_offset;
   off_t strtab_offset;
 
+  int machine;
+
+  /* Jump stubs (x86-64) and GOT slots (x86-64, RISC-V) for symbols out of reach, one of each per symbol at most */
+  uint8_t* stubs;
+  size_t stubs_size;
+  size_t stub_count;
+  Elf_Addr* got;
+  size_t got_count;
+
   ELFLoaderSection_t* section;
 };
 
@@ -60,12 +127,15 @@ void unalignedSet8(void* dest, uint8_t value);
 uint32_t unalignedGet32(void* src);
 void unalignedSet32(void* dest, uint32_t value);
 void unalignedCpy(void* dest, void* src, size_t n);
-int readSection(ELFLoaderContext_t* ctx, int n, Elf32_Shdr* h, char* name, size_t name_len);
-int readSymbol(ELFLoaderContext_t* ctx, int n, Elf32_Sym* sym, char* name, size_t nlen);
-const char* type2String(int symt);
-int relocateSymbol(Elf32_Addr relAddr, int type, Elf32_Addr symAddr, Elf32_Addr defAddr, uint32_t* from, uint32_t* to);
+void* loaderMap(size_t size);
+int readSection(ELFLoaderContext_t* ctx, int n, Elf_Shdr* h, char* name, size_t name_len);
+int readSymbol(ELFLoaderContext_t* ctx, int n, Elf_Sym* sym, char* name, size_t nlen);
+const char* type2String(int machine, int symt);
+int relocateSymbol(Elf_Addr relAddr, int type, Elf_Addr symAddr, Elf_Addr defAddr, uint32_t* from, uint32_t* to);
+int relocateSymbolX86_64(ELFLoaderContext_t* ctx, Elf_Addr relAddr, int type, Elf_Addr symAddr, int64_t addend);
+int relocateSymbolRISCV(ELFLoaderContext_t* ctx, Elf_Addr relAddr, int type, Elf_Addr symAddr, Elf_Addr hiAddr);
 ELFLoaderSection_t* findSection(ELFLoaderContext_t* ctx, int index);
-Elf32_Addr findSymAddr(ELFLoaderContext_t* ctx, Elf32_Sym* sym, const char* sName);
+Elf_Addr findSymAddr(ELFLoaderContext_t* ctx, Elf_Sym* sym, const char* sName);
 int relocateSection(ELFLoaderContext_t* ctx, ELFLoaderSection_t* s);
 void elfLoaderFree(ELFLoaderContext_t* ctx);
 ELFLoaderContext_t* elfLoaderInitLoadAndRelocate(void* fd, const ELFLoaderEnv_t* env);
@@ -0,0 +1,61 @@
+#include "trace.h"
+#ifdef __linux
+#include <time.h>
+#else
+#include "esp_timer.h"
+#endif
+
+static TraceEvent_t traceBuffer[TRACE_EVENTS];
+static size_t traceHead = 0;  // Index of the oldest event
+static size_t traceSize = 0;
+static uint32_t traceOverwritten = 0;
+
+
+int64_t traceNow(void) {
+#ifdef __linux
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+  return esp_timer_get_time();
+#endif
+}
+
+void traceEvent(const char* name, char phase, uint32_t value) {
+  TraceEvent_t* event;
+  if (traceSize < TRACE_EVENTS) {
+    event = &traceBuffer[(traceHead + traceSize) % TRACE_EVENTS];
+    traceSize++;
+  } else {
+    // Full, overwrite the oldest event
+    event = &traceBuffer[traceHead];
+    traceHead = (traceHead + 1) % TRACE_EVENTS;
+    traceOverwritten++;
+  }
+  event->time = traceNow();
+  event->name = name;
+  event->phase = phase;
+  event->value = value;
+}
+
+size_t traceCount(void) {
+  return traceSize;
+}
+
+/* n-th event, oldest first */
+const TraceEvent_t* traceAt(size_t n) {
+  if (n >= traceSize) {
+    return NULL;
+  }
+  return &traceBuffer[(traceHead + n) % TRACE_EVENTS];
+}
+
+uint32_t traceDropped(void) {
+  return traceOverwritten;
+}
+
+void traceClear(void) {
+  traceHead = 0;
+  traceSize = 0;
+  traceOverwritten = 0;
+}
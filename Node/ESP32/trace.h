@@ -0,0 +1,34 @@
+#ifndef __TESSIE_TRACE__
+#define __TESSIE_TRACE__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Ring buffer of timestamped node lifecycle events (uploads, /execute, the loader, the task run,
+ * the output stream). The commander drains it through /trace and aligns the timestamps to its
+ * own clock through /clock. Events are recorded from the loop task only, so there is no locking.
+ */
+
+#define TRACE_EVENTS 256 /*!< Ring buffer size, the oldest events are overwritten when it is full */
+
+#define TRACE_BEGIN 'B'
+#define TRACE_END 'E'
+#define TRACE_INSTANT 'I'
+
+typedef struct {
+  int64_t time;     /*!< Microseconds since boot */
+  const char* name; /*!< Static string naming the event */
+  char phase;       /*!< TRACE_BEGIN, TRACE_END or TRACE_INSTANT */
+  uint32_t value;   /*!< Event specific, e.g. bytes written */
+} TraceEvent_t;
+
+/* Function prototypes */
+int64_t traceNow(void);
+void traceEvent(const char* name, char phase, uint32_t value);
+size_t traceCount(void);
+const TraceEvent_t* traceAt(size_t n);
+uint32_t traceDropped(void);
+void traceClear(void);
+
+#endif /* __TESSIE_TRACE__ */
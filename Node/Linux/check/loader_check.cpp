@@ -0,0 +1,153 @@
+/*
+  Relocation check of the ELF loader on objects of another machine, run by `make check`.
+
+  Built with LOADER_MACHINE=EM_RISCV, the loader loads and relocates rv32 objects without running them, into the
+  fixed arena of loader_check.h. The relocated image, every byte the loader allocated, is compared with the golden
+  image checked in next to the object. -w writes the image instead, after a deliberate change of the loader's
+  output; check it against a linker first, see check/rv32/README.md.
+
+  check/loader_check [-w] OBJECT IMAGE
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "loader.h"
+#include "loader_check.h"
+
+static uint8_t* arena = NULL;
+static size_t arena_used = 0;
+
+void* checkAlloc(size_t size) {
+    size_t offset = (arena_used + CHECK_ARENA_ALIGN - 1) & ~(size_t)(CHECK_ARENA_ALIGN - 1);
+    if (offset + size > CHECK_ARENA_SIZE) {
+        return NULL;
+    }
+    arena_used = offset + size;
+    return arena + offset;
+}
+
+// What the tasks call and reference, at fixed addresses of the ESP32-C3's ROM, flash and RAM
+static const ELFLoaderSymbol_t exports[] = {
+    { "puts", (void*)0x42001040 },      { "printf", (void*)0x42001080 },   { "sscanf", (void*)0x420010c0 },
+    { "fopen", (void*)0x42001100 },     { "fprintf", (void*)0x42001140 },  { "fclose", (void*)0x42001180 },
+    { "__adddf3", (void*)0x40000600 },  { "__muldf3", (void*)0x40000640 }, { "__divdf3", (void*)0x40000680 },
+    { "__floatsidf", (void*)0x400006c0 }, { "far_value", (void*)0x3fc80010 },
+};
+static const ELFLoaderEnv_t env = { exports, sizeof(exports) / sizeof(exports[0]) };
+
+static uint8_t* read_file(const char* path, size_t* size) {
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* data = (uint8_t*)malloc(*size ? *size : 1);
+    if (fread(data, 1, *size, f) != *size) {
+        perror(path);
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+// The loaded section holding arena offset `offset`, for the report of a difference
+static void describe(ELFLoaderContext_t* ctx, size_t offset) {
+    for (ELFLoaderSection_t* s = ctx->section; s != NULL; s = s->next) {
+        size_t start = (uint8_t*)s->data - arena;
+        if (offset >= start && offset < start + s->size) {
+            Elf_Shdr h;
+            char name[33] = "<unnamed>";
+            readSection(ctx, s->secIdx, &h, name, sizeof(name));
+            fprintf(stderr, "  in %s at +0x%zx\n", name, offset - start);
+            return;
+        }
+    }
+    if (ctx->stubs != NULL && offset >= (size_t)(ctx->stubs - arena)) {
+        fprintf(stderr, "  in the GOT at +0x%zx\n", offset - (ctx->stubs - arena));
+    }
+}
+
+int main(int argc, char** argv) {
+    int write_image = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "w")) != -1) {
+        if (opt != 'w') {
+            fprintf(stderr, "usage: %s [-w] OBJECT IMAGE\n", argv[0]);
+            return 2;
+        }
+        write_image = 1;
+    }
+    if (argc - optind != 2) {
+        fprintf(stderr, "usage: %s [-w] OBJECT IMAGE\n", argv[0]);
+        return 2;
+    }
+    const char* object_path = argv[optind];
+    const char* image_path = argv[optind + 1];
+
+    void* mapped = mmap((void*)CHECK_ARENA_ADDR, CHECK_ARENA_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (mapped != (void*)CHECK_ARENA_ADDR) {
+        fprintf(stderr, "Can't map the arena at 0x%lx\n", CHECK_ARENA_ADDR);
+        return 1;
+    }
+    arena = (uint8_t*)mapped;
+
+    size_t object_size = 0;
+    uint8_t* object = read_file(object_path, &object_size);
+    if (object == NULL) {
+        return 1;
+    }
+    ELFLoaderContext_t* ctx = elfLoaderInitLoadAndRelocate(object, &env);
+    if (ctx == NULL) {
+        fprintf(stderr, "%s: load failed\n", object_path);
+        return 1;
+    }
+
+    if (write_image) {
+        FILE* f = fopen(image_path, "wb");
+        if (f == NULL || fwrite(arena, 1, arena_used, f) != arena_used || fclose(f) != 0) {
+            perror(image_path);
+            return 1;
+        }
+        // Where each section went, to link the object at the same addresses; the list is in reverse load order
+        for (ELFLoaderSection_t* s = ctx->section; s != NULL; s = s->next) {
+            Elf_Shdr h;
+            char name[33] = "<unnamed>";
+            readSection(ctx, s->secIdx, &h, name, sizeof(name));
+            printf("%s 0x%lx %zu\n", name, (unsigned long)(uintptr_t)s->data, s->size);
+        }
+        if (ctx->got_count) {
+            printf("GOT 0x%lx %zu\n", (unsigned long)(uintptr_t)ctx->got, ctx->got_count * sizeof(Elf_Addr));
+        }
+        printf("%s: wrote %zu bytes\n", image_path, arena_used);
+        return 0;
+    }
+
+    size_t golden_size = 0;
+    uint8_t* golden = read_file(image_path, &golden_size);
+    if (golden == NULL) {
+        return 1;
+    }
+    size_t common = golden_size < arena_used ? golden_size : arena_used;
+    for (size_t n = 0; n < common; n++) {
+        if (arena[n] != golden[n]) {
+            fprintf(stderr, "%s: differs from %s at byte %zu (0x%02x, expected 0x%02x)\n", object_path, image_path,
+                    n, arena[n], golden[n]);
+            describe(ctx, n);
+            return 1;
+        }
+    }
+    if (golden_size != arena_used) {
+        fprintf(stderr, "%s: %zu bytes relocated, %s has %zu\n", object_path, arena_used, image_path, golden_size);
+        return 1;
+    }
+    printf("%s: %zu bytes match\n", object_path, arena_used);
+    return 0;
+}
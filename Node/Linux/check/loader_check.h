@@ -0,0 +1,20 @@
+/*
+  Included ahead of the loader when `make check` builds it: the sections and GOT slots go to one arena at a fixed
+  address instead of the mmap calls of the node, so an object relocates to the same bytes on every run and host.
+*/
+#ifndef __LOADER_CHECK__
+#define __LOADER_CHECK__
+
+#include <stddef.h>
+
+#define CHECK_ARENA_ADDR 0x10000000UL /* Low enough for the 32 bit addresses of rv32 objects */
+#define CHECK_ARENA_SIZE (1 << 20)
+#define CHECK_ARENA_ALIGN 16
+
+void* checkAlloc(size_t size);
+
+#define LOADER_ALLOC_EXEC(size) checkAlloc(size)
+#define LOADER_ALLOC_DATA(size) checkAlloc(size)
+#define LOADER_FREE(ptr, size)
+
+#endif /* __LOADER_CHECK__ */
@@ -0,0 +1,73 @@
+# Every relocation the loader's RISC-V backend handles, see README.md
+  .option relax
+  .text
+  .globl local_main
+  .p2align 1
+  .type local_main,@function
+local_main:
+  .cfi_startproc
+  addi sp, sp, -16
+  .cfi_def_cfa_offset 16
+  sw ra, 12(sp)
+  .cfi_offset ra, -4
+  lui a2, %hi(counter)
+  lw a3, %lo(counter)(a2)
+  addi a3, a3, 1
+  sw a3, %lo(counter)(a2)
+  beqz a1, 1f
+  bge a1, a3, 2f
+1:
+  la a0, message
+  call puts
+2:
+.Lpc:
+  auipc a4, %pcrel_hi(table)
+  sw a1, %pcrel_lo(.Lpc)(a4)
+  jal ra, near
+  jal helper
+  j 3f
+near:
+  ret
+3:
+  .option push
+  .option pic
+  la a5, far_value
+  .option pop
+  lw a5, 0(a5)
+  lla a0, fmt
+  call printf
+  call rom_fn
+  bnez a0, 1b
+  lw ra, 12(sp)
+  addi sp, sp, 16
+  ret
+  .cfi_endproc
+  .size local_main, .-local_main
+
+  .section .text.helper,"ax",@progbits
+  .p2align 1
+helper:
+  .cfi_startproc
+  lla a0, jumps
+  lw a0, 0(a0)
+  jr a0
+  .cfi_endproc
+
+  .section .rodata
+message: .asciz "hello"
+fmt: .asciz "%d\n"
+  .p2align 2
+jumps:
+  .word 3b - local_main
+  .byte 2b - 1b
+  .half 3b - 1b
+
+  .data
+  .p2align 2
+table: .word local_main, message+4, puts
+counter: .word 0
+
+  .bss
+buffer: .zero 64
+  .globl rom_fn
+  .set rom_fn, 0x40000500
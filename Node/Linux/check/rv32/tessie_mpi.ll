@@ -0,0 +1,77 @@
+; Tasks/tessie_mpi.c for rv32, with a counter of runs in .sbss; see README.md
+target datalayout = "e-m:e-p:32:32-i64:64-n32-S128"
+target triple = "riscv32-unknown-unknown-elf"
+
+@.in = private constant [19 x i8] c"Input payload: %s\0A\00"
+@.fmt = private constant [6 x i8] c"%d:%d\00"
+@.fail = private constant [44 x i8] c"Failed to parse range from arg. Parsed: %d\0A\00"
+@.range = private constant [24 x i8] c"Parsed range: %d to %d\0A\00"
+@.res = private constant [44 x i8] c"Pi approximation for range %d to %d: %.15f\0A\00"
+@.path = private constant [20 x i8] c"/spiffs/task_output\00"
+@.w = private constant [2 x i8] c"w\00"
+@.out = private constant [12 x i8] c"%d:%d %.15f\00"
+@.nofile = private constant [33 x i8] c"Failed to open task output file.\00"
+@runs = dso_local global i32 0
+
+define dso_local double @calculate_pi(i32 %start, i32 %end) {
+entry:
+  %c = icmp slt i32 %start, %end
+  br i1 %c, label %loop, label %done
+loop:
+  %i = phi i32 [ %start, %entry ], [ %i1, %loop ]
+  %sign = phi i32 [ 1, %entry ], [ %nsign, %loop ]
+  %pi = phi double [ 0.0, %entry ], [ %npi, %loop ]
+  %sf = sitofp i32 %sign to double
+  %num = fmul double %sf, 4.0
+  %if = sitofp i32 %i to double
+  %d2 = fmul double %if, 2.0
+  %den = fadd double %d2, 1.0
+  %q = fdiv double %num, %den
+  %npi = fadd double %pi, %q
+  %nsign = sub i32 0, %sign
+  %i1 = add i32 %i, 1
+  %c2 = icmp slt i32 %i1, %end
+  br i1 %c2, label %loop, label %done
+done:
+  %r = phi double [ 0.0, %entry ], [ %npi, %loop ]
+  ret double %r
+}
+
+declare i32 @printf(i8*, ...)
+declare i32 @sscanf(i8*, i8*, ...)
+declare i8* @fopen(i8*, i8*)
+declare i32 @fprintf(i8*, i8*, ...)
+declare i32 @fclose(i8*)
+declare i32 @puts(i8*)
+
+define dso_local void @local_main(i8* %arg, i32 %len) {
+entry:
+  %start = alloca i32
+  %end = alloca i32
+  %n = load i32, i32* @runs
+  %n1 = add i32 %n, 1
+  store i32 %n1, i32* @runs
+  call i32 (i8*, ...) @printf(i8* getelementptr ([19 x i8], [19 x i8]* @.in, i32 0, i32 0), i8* %arg)
+  %p = call i32 (i8*, i8*, ...) @sscanf(i8* %arg, i8* getelementptr ([6 x i8], [6 x i8]* @.fmt, i32 0, i32 0), i32* %start, i32* %end)
+  %ok = icmp eq i32 %p, 2
+  br i1 %ok, label %parsed, label %fail
+fail:
+  call i32 (i8*, ...) @printf(i8* getelementptr ([44 x i8], [44 x i8]* @.fail, i32 0, i32 0), i32 %p)
+  ret void
+parsed:
+  %s = load i32, i32* %start
+  %e = load i32, i32* %end
+  call i32 (i8*, ...) @printf(i8* getelementptr ([24 x i8], [24 x i8]* @.range, i32 0, i32 0), i32 %s, i32 %e)
+  %r = call double @calculate_pi(i32 %s, i32 %e)
+  call i32 (i8*, ...) @printf(i8* getelementptr ([44 x i8], [44 x i8]* @.res, i32 0, i32 0), i32 %s, i32 %e, double %r)
+  %f = call i8* @fopen(i8* getelementptr ([20 x i8], [20 x i8]* @.path, i32 0, i32 0), i8* getelementptr ([2 x i8], [2 x i8]* @.w, i32 0, i32 0))
+  %isnull = icmp eq i8* %f, null
+  br i1 %isnull, label %nofile, label %write
+write:
+  call i32 (i8*, i8*, ...) @fprintf(i8* %f, i8* getelementptr ([12 x i8], [12 x i8]* @.out, i32 0, i32 0), i32 %s, i32 %e, double %r)
+  call i32 @fclose(i8* %f)
+  ret void
+nofile:
+  call i32 @puts(i8* getelementptr ([33 x i8], [33 x i8]* @.nofile, i32 0, i32 0))
+  ret void
+}
@@ -0,0 +1,241 @@
+/*
+  Benchmark of the task I/O helpers in Tasks/tessie_io.h against fscanf and fgets.
+
+  Writes inputs shaped like the task inputs (one number per line as tessie_chaos reads, CSV rows of
+  integers, text lines), reads each with stdio and with tessie_io, checks both read the same values
+  and prints the time and throughput of each. Run on the host, the relative gain carries over to the
+  nodes, where newlib's fscanf on SPIFFS is slower still.
+
+  ./io_bench [-n RECORDS] [-b BUFFER_BYTES] [-r REPEAT] [-d DIR]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../../Tasks/tessie_io.h"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long file_size(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        return 0;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+static void write_inputs(const char* doubles, const char* csv, long records) {
+    FILE* f = fopen(doubles, "w");
+    srand(1911);
+    for (long i = 0; i < records; i++) {
+        // Values like the sensor series tessie_chaos gets, mixed magnitudes and signs
+        double v = (rand() - RAND_MAX / 2) / (double)(1 << (rand() % 20));
+        fprintf(f, i % 7 == 0 ? "%.15g\n" : "%.6f\n", v);
+    }
+    fclose(f);
+
+    f = fopen(csv, "w");
+    for (long i = 0; i < records / 4; i++) {
+        fprintf(f, "%ld,%d,%d,%d\n", i, rand() % 100000, -(rand() % 1000), rand());
+    }
+    fclose(f);
+}
+
+typedef struct {
+    double seconds;
+    long count;
+    double sum;
+} result_t;
+
+static result_t doubles_fscanf(const char* path) {
+    result_t res = { 0, 0, 0 };
+    double t = now();
+    FILE* f = fopen(path, "r");
+    double v;
+    while (fscanf(f, "%lf", &v) == 1) {
+        res.sum += v;
+        res.count++;
+    }
+    fclose(f);
+    res.seconds = now() - t;
+    return res;
+}
+
+static result_t doubles_tessie(const char* path, char* buf, size_t size) {
+    result_t res = { 0, 0, 0 };
+    double t = now();
+    tessie_reader_t r;
+    double v;
+    if (tessie_reader_open(&r, path, buf, size) != 0) {
+        exit(1);
+    }
+    while (tessie_read_double(&r, &v)) {
+        res.sum += v;
+        res.count++;
+    }
+    tessie_reader_close(&r);
+    res.seconds = now() - t;
+    return res;
+}
+
+static result_t longs_fscanf(const char* path) {
+    result_t res = { 0, 0, 0 };
+    double t = now();
+    FILE* f = fopen(path, "r");
+    long a, b, c, d;
+    while (fscanf(f, "%ld,%ld,%ld,%ld", &a, &b, &c, &d) == 4) {
+        res.sum += a + b + c + d;
+        res.count += 4;
+    }
+    fclose(f);
+    res.seconds = now() - t;
+    return res;
+}
+
+static result_t longs_tessie(const char* path, char* buf, size_t size) {
+    result_t res = { 0, 0, 0 };
+    double t = now();
+    tessie_reader_t r;
+    long v;
+    if (tessie_reader_open(&r, path, buf, size) != 0) {
+        exit(1);
+    }
+    while (tessie_read_long(&r, &v)) {
+        res.sum += v;
+        res.count++;
+    }
+    tessie_reader_close(&r);
+    res.seconds = now() - t;
+    return res;
+}
+
+static result_t lines_fgets(const char* path) {
+    result_t res = { 0, 0, 0 };
+    double t = now();
+    FILE* f = fopen(path, "r");
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        res.sum += strlen(line) - 1;
+        res.count++;
+    }
+    fclose(f);
+    res.seconds = now() - t;
+    return res;
+}
+
+static result_t lines_tessie(const char* path, char* buf, size_t size) {
+    result_t res = { 0, 0, 0 };
+    double t = now();
+    tessie_reader_t r;
+    const char* line;
+    size_t len;
+    if (tessie_reader_open(&r, path, buf, size) != 0) {
+        exit(1);
+    }
+    while (tessie_read_line(&r, &line, &len)) {
+        res.sum += len;
+        res.count++;
+    }
+    tessie_reader_close(&r);
+    res.seconds = now() - t;
+    return res;
+}
+
+// The best of repeat runs, to keep the page cache and the first run's misses out of the numbers
+#define BEST(res, repeat, call)                     \
+    do {                                            \
+        res = call;                                 \
+        for (int i_ = 1; i_ < (repeat); i_++) {     \
+            result_t again_ = call;                 \
+            if (again_.seconds < res.seconds) {     \
+                res = again_;                       \
+            }                                       \
+        }                                           \
+    } while (0)
+
+static int report(const char* name, long bytes, result_t stdio, result_t tessie) {
+    double diff = stdio.sum > tessie.sum ? stdio.sum - tessie.sum : tessie.sum - stdio.sum;
+    double scale = stdio.sum > 0 ? stdio.sum : -stdio.sum;
+    int same = stdio.count == tessie.count && diff <= scale * 1e-12;
+    printf("%-8s %9ld %10.1f %10.1f %10.1f %10.1f %8.1fx %s\n", name, stdio.count,
+           stdio.seconds * 1000, bytes / stdio.seconds / 1e6, tessie.seconds * 1000, bytes / tessie.seconds / 1e6,
+           stdio.seconds / tessie.seconds, same ? "same" : "DIFFERENT");
+    return same ? 0 : 1;
+}
+
+// Count the numbers the two readers parse differently, and the largest difference in ulps
+static void compare_doubles(const char* path, char* buf, size_t size) {
+    FILE* f = fopen(path, "r");
+    tessie_reader_t r;
+    double a, b;
+    long differ = 0, ulps = 0;
+    if (tessie_reader_open(&r, path, buf, size) != 0) {
+        exit(1);
+    }
+    while (fscanf(f, "%lf", &a) == 1 && tessie_read_double(&r, &b)) {
+        if (a != b) {
+            long long ia, ib;
+            memcpy(&ia, &a, sizeof(ia));
+            memcpy(&ib, &b, sizeof(ib));
+            long d = (long)llabs(ia - ib);
+            differ++;
+            ulps = d > ulps ? d : ulps;
+        }
+    }
+    tessie_reader_close(&r);
+    fclose(f);
+    printf("doubles parsed differently from fscanf: %ld, at most %ld ulp\n", differ, ulps);
+}
+
+int main(int argc, char** argv) {
+    long records = 1000000;
+    size_t size = 4096;
+    int repeat = 3;
+    const char* dir = "/tmp";
+    int opt;
+    while ((opt = getopt(argc, argv, "n:b:r:d:")) != -1) {
+        switch (opt) {
+            case 'n': records = atol(optarg); break;
+            case 'b': size = (size_t)atol(optarg); break;
+            case 'r': repeat = atoi(optarg); break;
+            case 'd': dir = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-n RECORDS] [-b BUFFER_BYTES] [-r REPEAT] [-d DIR]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    char doubles[512], csv[512];
+    snprintf(doubles, sizeof(doubles), "%s/io_bench_doubles.txt", dir);
+    snprintf(csv, sizeof(csv), "%s/io_bench_rows.csv", dir);
+    write_inputs(doubles, csv, records);
+    char* buf = malloc(size);
+
+    printf("%ld records, %zu byte buffer, best of %d\n", records, size, repeat);
+    printf("%-8s %9s %10s %10s %10s %10s %9s\n", "input", "values", "stdio ms", "stdio MB/s", "tessie ms", "tessie MB/s", "speedup");
+    result_t a, b;
+    int failed = 0;
+    BEST(a, repeat, doubles_fscanf(doubles));
+    BEST(b, repeat, doubles_tessie(doubles, buf, size));
+    failed |= report("doubles", file_size(doubles), a, b);
+    BEST(a, repeat, longs_fscanf(csv));
+    BEST(b, repeat, longs_tessie(csv, buf, size));
+    failed |= report("csv", file_size(csv), a, b);
+    BEST(a, repeat, lines_fgets(doubles));
+    BEST(b, repeat, lines_tessie(doubles, buf, size));
+    failed |= report("lines", file_size(doubles), a, b);
+    compare_doubles(doubles, buf, size);
+
+    free(buf);
+    remove(doubles);
+    remove(csv);
+    return failed;
+}
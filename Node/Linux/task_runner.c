@@ -0,0 +1,204 @@
+/*
+  Native runner of a task, to test and profile tasks at host speed before they go to the nodes.
+
+  `make runner/<task>` compiles ../../Tasks/<task>.c natively together with this file into runner/<task>,
+  which calls the task's local_main(arg, len) as the nodes do. The task's fopen calls on /spiffs/task_input
+  and /spiffs/task_output open the files given with -i and -o, any other /spiffs/... path a file in DIR.
+
+  Every run is a child process, so the task starts from fresh static variables as it does after a load on
+  a node, and a crash is reported rather than taking the runner down. Only local_main is timed. -f runs
+  the task in the runner's own process instead, as gprof needs for its gmon.out; static variables then
+  keep their values from one run to the next, which few tasks expect.
+
+  ./runner/<task> [-i INPUT] [-o OUTPUT] [-d DIR] [-n RUNS] [-w WARMUP] [-q] [-f] [ARG...]
+*/
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SPIFFS_PREFIX "/spiffs/"
+
+typedef FILE* (*fopen_t)(const char*, const char*);
+
+void local_main(const char* arg, size_t len);
+
+static const char* dir = ".";
+static const char* input_path = NULL;
+static const char* output_path = NULL;
+
+// The task opens /spiffs/..., give it the local files instead
+FILE* fopen(const char* path, const char* mode) {
+    static fopen_t real_fopen = NULL;
+    if (real_fopen == NULL) {
+        real_fopen = (fopen_t)dlsym(RTLD_NEXT, "fopen");
+    }
+    if (path != NULL && strncmp(path, SPIFFS_PREFIX, strlen(SPIFFS_PREFIX)) == 0) {
+        const char* name = path + strlen(SPIFFS_PREFIX);
+        char mapped[4096];
+        if (input_path != NULL && strcmp(name, "task_input") == 0) {
+            return real_fopen(input_path, mode);
+        }
+        if (output_path != NULL && strcmp(name, "task_output") == 0) {
+            return real_fopen(output_path, mode);
+        }
+        snprintf(mapped, sizeof(mapped), "%s/%s", dir, name);
+        return real_fopen(mapped, mode);
+    }
+    return real_fopen(path, mode);
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// local_main with the task's stdout sent to /dev/null when quiet, returns its seconds
+static double call_task(const char* arg, size_t len, int quiet) {
+    int saved = -1;
+    if (quiet) {
+        fflush(stdout);
+        saved = dup(STDOUT_FILENO);
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        close(null);
+    }
+    double t = now();
+    local_main(arg, len);
+    t = now() - t;
+    fflush(stdout);
+    if (saved >= 0) {
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+    }
+    return t;
+}
+
+// One run of the task, in a child process unless in_process; returns its seconds, -1 if it failed
+static double run(const char* arg, size_t len, int quiet, int in_process) {
+    if (in_process) {
+        return call_task(arg, len, quiet);
+    }
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        return -1;
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return -1;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        double t = call_task(arg, len, quiet);
+        if (write(fds[1], &t, sizeof(t)) != sizeof(t)) {
+            _exit(1);
+        }
+        exit(0);
+    }
+
+    close(fds[1]);
+    double t = -1;
+    if (read(fds[0], &t, sizeof(t)) != sizeof(t)) {
+        t = -1;
+    }
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (WIFSIGNALED(status)) {
+        fprintf(stderr, "Task crashed with signal %d\n", WTERMSIG(status));
+        return -1;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "Task failed\n");
+        return -1;
+    }
+    return t;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char** argv) {
+    int runs = 1, warmup = 0, quiet = 0, in_process = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:o:d:n:w:qf")) != -1) {
+        switch (opt) {
+            case 'i': input_path = optarg; break;
+            case 'o': output_path = optarg; break;
+            case 'd': dir = optarg; break;
+            case 'n': runs = atoi(optarg); break;
+            case 'w': warmup = atoi(optarg); break;
+            case 'q': quiet = 1; break;
+            case 'f': in_process = 1; break;
+            default:
+                fprintf(stderr,
+                        "usage: %s [-i INPUT] [-o OUTPUT] [-d DIR] [-n RUNS] [-w WARMUP] [-q] [-f] [ARG...]\n"
+                        "  -i INPUT   file the task reads as /spiffs/task_input (default DIR/task_input)\n"
+                        "  -o OUTPUT  file the task writes as /spiffs/task_output (default DIR/task_output)\n"
+                        "  -d DIR     directory of the task's other /spiffs/... files (default .)\n"
+                        "  -n RUNS    timed runs (default 1)\n"
+                        "  -w WARMUP  runs before the timed ones, not counted\n"
+                        "  -q         discard the task's stdout\n"
+                        "  -f         run in this process rather than a child per run, for gprof\n"
+                        "  ARG...     the task argument, joined with spaces\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+    if (runs < 1) {
+        runs = 1;
+    }
+
+    // The argument as the node passes it: the bytes the commander sent, with their length
+    size_t len = 0;
+    for (int i = optind; i < argc; i++) {
+        len += strlen(argv[i]) + 1;
+    }
+    char* arg = calloc(len + 1, 1);
+    for (int i = optind; i < argc; i++) {
+        strcat(arg, argv[i]);
+        if (i + 1 < argc) {
+            strcat(arg, " ");
+        }
+    }
+    len = strlen(arg);
+
+    for (int i = 0; i < warmup; i++) {
+        if (run(arg, len, quiet, in_process) < 0) {
+            return 1;
+        }
+    }
+    double* times = malloc(runs * sizeof(double));
+    double total = 0;
+    for (int i = 0; i < runs; i++) {
+        times[i] = run(arg, len, quiet, in_process);
+        if (times[i] < 0) {
+            return 1;
+        }
+        total += times[i];
+    }
+
+    if (runs == 1) {
+        fprintf(stderr, "local_main: %.3f ms\n", times[0] * 1e3);
+    } else {
+        qsort(times, runs, sizeof(double), compare_doubles);
+        double median = runs % 2 ? times[runs / 2] : (times[runs / 2 - 1] + times[runs / 2]) / 2;
+        fprintf(stderr, "local_main, %d runs: min %.3f ms, median %.3f ms, mean %.3f ms, max %.3f ms\n", runs,
+                times[0] * 1e3, median * 1e3, total / runs * 1e3, times[runs - 1] * 1e3);
+    }
+    free(times);
+    free(arg);
+    return 0;
+}
@@ -0,0 +1,598 @@
+/*
+  Tesselator (tessie) node for Linux
+  https://github.com/invpe/Tesselator
+
+  Speaks the same protocol as the ESP32 node (see Node/ESP32/ESP32.ino): the UDP beacon
+  on port 1911 and the /uploadbin, /uploadpayload, /arg, /execute, /output, /status,
+  /clock and /trace HTTP endpoints. Like the ESP32 it serves HTTP from a single loop
+  that also runs the task, so a node that is running a task answers nothing but its
+  beacon until the task is done.
+
+  Tasks are host-compiled objects exposing local_main(const char*, size_t): either
+  relocatable objects (-r), loaded by the same ELF loader as the ESP32 with its x86-64
+  backend and given the same exported functions, or shared objects, loaded by dlopen.
+  The task files live in <root>/spiffs/task_*, and fopen calls of the task on
+  /spiffs/... paths are redirected there, so task sources build unchanged.
+*/
+#include <arpa/inet.h>
+#include <dlfcn.h>
+#include <dirent.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include "../ESP32/loader.h"
+#include "../ESP32/trace.h"
+
+#define BINARY_FILE "/task_binary"
+#define INPUT_FILE "/task_input"
+#define OUTPUT_FILE "/task_output"
+#define SPIFFS_PREFIX "/spiffs/"
+#define UDP_PORT 1911
+#define BROADCAST_TIMER 5000
+#define SPIFFS_BYTES 1441792  // Default ESP32 SPIFFS partition
+#define HTTP_MAX_DATA_WAIT 5  // Seconds to wait for a client, as the ESP32 WebServer does
+#define HTTP_MAX_HEADER 8192
+
+std::string strAddress = "127.0.0.1";
+std::string strBroadcast = "255.255.255.255";
+std::string strSpiffs;
+int iHttpPort = 80;
+int iBeaconMs = BROADCAST_TIMER;
+int iRssi = -40;
+size_t uiSpiffsBytes = SPIFFS_BYTES;
+double dCpuScale = 1.0;
+std::atomic<bool> bBusy(false);
+std::atomic<uint32_t> uiTotalExecuted(0);
+std::string strArgument;
+
+typedef FILE* (*fopen_t)(const char*, const char*);
+typedef void (*func_t)(const char*, size_t len);
+
+// A loaded task, from the ELF loader or from dlopen
+typedef struct {
+  unsigned char* elf;
+  ELFLoaderContext_t* ctx;
+  void* handle;
+  func_t func;
+} Task_t;
+
+// Tasks open /spiffs/task_*, keep them inside this node's directory
+extern "C" FILE* fopen(const char* path, const char* mode) {
+  static fopen_t real_fopen = (fopen_t)dlsym(RTLD_NEXT, "fopen");
+  if (path != NULL && strncmp(path, SPIFFS_PREFIX, strlen(SPIFFS_PREFIX)) == 0 && !strSpiffs.empty()) {
+    std::string strPath = strSpiffs + "/" + (path + strlen(SPIFFS_PREFIX));
+    return real_fopen(strPath.c_str(), mode);
+  }
+  return real_fopen(path, mode);
+}
+
+std::string SpiffsPath(const char* name) {
+  return strSpiffs + name;
+}
+
+// Load task binary directly from file
+unsigned char* LoadELFFile(const char* path, size_t* file_size) {
+  FILE* file = fopen(path, "rb");
+  if (!file) {
+    printf("Failed to open file.\n");
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  *file_size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  unsigned char* buffer = (unsigned char*)malloc(*file_size);
+  if (!buffer || fread(buffer, 1, *file_size, file) != *file_size) {
+    printf("Failed to read binary file.\n");
+    free(buffer);
+    fclose(file);
+    return NULL;
+  }
+  fclose(file);
+  return buffer;
+}
+
+// Relocatable objects go through the ELF loader with the ESP32's exports, anything else through dlopen
+bool LoadTask(Task_t* task, const char** error) {
+  memset(task, 0, sizeof(Task_t));
+  std::string strPath = SpiffsPath(BINARY_FILE);
+  size_t elf_file_size = 0;
+  traceEvent("elf_read", TRACE_BEGIN, 0);
+  task->elf = LoadELFFile(strPath.c_str(), &elf_file_size);
+  traceEvent("elf_read", TRACE_END, elf_file_size);
+  if (!task->elf) {
+    *error = "Failed to load ELF binary";
+    return false;
+  }
+
+  Elf_Ehdr* header = (Elf_Ehdr*)task->elf;
+  if (elf_file_size >= sizeof(Elf_Ehdr) && memcmp(header->e_ident, "\x7f" "ELF", 4) == 0 && header->e_type == ET_REL) {
+    static const ELFLoaderSymbol_t exports[] = {
+      { "puts", (void*)puts },
+      { "printf", (void*)printf },
+      { "fgets", (void*)fgets },
+      { "fread", (void*)fread },
+      { "fwrite", (void*)fwrite },
+      { "fopen", (void*)fopen },
+      { "fclose", (void*)fclose },
+      { "fprintf", (void*)fprintf },
+      { "fseek", (void*)fseek },
+      { "ftell", (void*)ftell },
+      { "fflush", (void*)fflush },
+      { "fscanf", (void*)fscanf },
+      // Emitted by the compiler for printf and fprintf of plain strings
+      { "fputs", (void*)fputs },
+      { "fputc", (void*)fputc },
+      { "putchar", (void*)putchar },
+      // Emitted by the compiler on its own for copies, clears, compares and stack protection,
+      // the ESP32 takes them from its ROM
+      { "memcpy", (void*)memcpy },
+      { "memset", (void*)memset },
+      { "memmove", (void*)memmove },
+      { "memcmp", (void*)memcmp },
+      { "__stack_chk_fail", dlsym(RTLD_DEFAULT, "__stack_chk_fail") },
+      // Host builds of the tasks also use these, glibc renames the scanf family
+      { "__isoc99_fscanf", dlsym(RTLD_DEFAULT, "__isoc99_fscanf") },
+      { "__isoc99_sscanf", dlsym(RTLD_DEFAULT, "__isoc99_sscanf") },
+      { "sscanf", (void*)sscanf },
+      { "malloc", (void*)malloc },
+      { "calloc", (void*)calloc },
+      { "free", (void*)free },
+      { "frexp", (void*)(double (*)(double, int*))frexp }
+    };
+    static const ELFLoaderEnv_t env = { exports, sizeof(exports) / sizeof(*exports) };
+    task->ctx = elfLoaderInitLoadAndRelocate(task->elf, &env);
+    if (!task->ctx) {
+      *error = "Failed to load ELF binary";
+      return false;
+    }
+    if (elfLoaderSetFunc(task->ctx, "local_main") != 0) {
+      *error = "Failed to set function";
+      return false;
+    }
+    task->func = (func_t)task->ctx->exec;
+    return true;
+  }
+
+  traceEvent("load", TRACE_BEGIN, 0);
+  task->handle = dlopen(strPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+  traceEvent("load", TRACE_END, task->handle != NULL);
+  if (!task->handle) {
+    printf("Failed to load task: %s\n", dlerror());
+    *error = "Failed to load ELF binary";
+    return false;
+  }
+  task->func = (func_t)dlsym(task->handle, "local_main");
+  if (!task->func) {
+    *error = "Failed to set function";
+    return false;
+  }
+  return true;
+}
+
+void FreeTask(Task_t* task) {
+  if (task->ctx) {
+    elfLoaderFree(task->ctx);
+  }
+  if (task->handle) {
+    dlclose(task->handle);
+  }
+  free(task->elf);
+}
+
+size_t SpiffsUsedBytes() {
+  size_t used = 0;
+  DIR* dir = opendir(strSpiffs.c_str());
+  if (!dir) {
+    return 0;
+  }
+  while (struct dirent* entry = readdir(dir)) {
+    struct stat st;
+    std::string strPath = strSpiffs + "/" + entry->d_name;
+    if (entry->d_name[0] != '.' && stat(strPath.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+      used += st.st_size;
+    }
+  }
+  closedir(dir);
+  return used;
+}
+
+std::string MacAddress() {
+  // Locally administered address made of the node's IP and port, stable across restarts
+  in_addr_t ip = ntohl(inet_addr(strAddress.c_str()));
+  char buffer[18];
+  snprintf(buffer, sizeof(buffer), "02:%02X:%02X:%02X:%02X:%02X", (ip >> 16) & 0xff, (ip >> 8) & 0xff, ip & 0xff,
+           (iHttpPort >> 8) & 0xff, iHttpPort & 0xff);
+  return buffer;
+}
+
+void BroadcastTimer() {
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  int enable = 1;
+  setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable));
+
+  // Beacon from the node's own address, the commander takes it as the node's IP
+  sockaddr_in local = {};
+  local.sin_family = AF_INET;
+  local.sin_addr.s_addr = inet_addr(strAddress.c_str());
+  if (bind(sock, (sockaddr*)&local, sizeof(local)) != 0) {
+    perror("Failed to bind the beacon socket");
+  }
+
+  sockaddr_in target = {};
+  target.sin_family = AF_INET;
+  target.sin_port = htons(UDP_PORT);
+  target.sin_addr.s_addr = inet_addr(strBroadcast.c_str());
+
+  std::string strMac = MacAddress();
+  while (true) {
+    size_t freeBytes = uiSpiffsBytes - std::min(uiSpiffsBytes, SpiffsUsedBytes());
+    std::string strAnnouncement = "{\"node\":\"TESSIE_NODE\",\"mac\":\"" + strMac + "\",\"total_executed\":"
+                                  + std::to_string(uiTotalExecuted) + ",\"status\":\"" + (bBusy ? "busy" : "available")
+                                  + "\",\"free_spiffs_bytes\":" + std::to_string(freeBytes) + ",\"rssi\":" + std::to_string(iRssi) + ",\"arch\":\"" + LOADER_ARCH + "\"}";
+    sendto(sock, strAnnouncement.c_str(), strAnnouncement.length(), 0, (sockaddr*)&target, sizeof(target));
+    std::this_thread::sleep_for(std::chrono::milliseconds(iBeaconMs));
+  }
+}
+
+/*** HTTP ***/
+
+struct Request {
+  std::string method;
+  std::string path;
+  std::string contentType;
+  std::string body;
+};
+
+bool SendAll(int client, const char* data, size_t size) {
+  while (size > 0) {
+    ssize_t sent = send(client, data, size, MSG_NOSIGNAL);
+    if (sent <= 0) {
+      return false;
+    }
+    data += sent;
+    size -= sent;
+  }
+  return true;
+}
+
+void Send(int client, int code, const char* contentType, const std::string& body) {
+  const char* reason = code == 200 ? "OK" : code == 404 ? "Not Found" : "Internal Server Error";
+  char header[256];
+  int length = snprintf(header, sizeof(header), "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                        code, reason, contentType, body.length());
+  SendAll(client, header, length);
+  SendAll(client, body.data(), body.length());
+}
+
+void SendJson(int client, int code, const std::string& body) {
+  Send(client, code, "application/json", body);
+}
+
+bool ReadRequest(int client, Request& request) {
+  std::string data;
+  char buffer[4096];
+  size_t headerEnd;
+  while ((headerEnd = data.find("\r\n\r\n")) == std::string::npos) {
+    if (data.length() > HTTP_MAX_HEADER) {
+      return false;
+    }
+    ssize_t received = recv(client, buffer, sizeof(buffer), 0);
+    if (received <= 0) {
+      return false;
+    }
+    data.append(buffer, received);
+  }
+
+  std::string strHead = data.substr(0, headerEnd);
+  size_t lineEnd = strHead.find("\r\n");
+  std::string strLine = strHead.substr(0, lineEnd);
+  size_t space1 = strLine.find(' ');
+  size_t space2 = strLine.find(' ', space1 + 1);
+  if (space1 == std::string::npos || space2 == std::string::npos) {
+    return false;
+  }
+  request.method = strLine.substr(0, space1);
+  request.path = strLine.substr(space1 + 1, space2 - space1 - 1);
+  request.path = request.path.substr(0, request.path.find('?'));
+
+  size_t contentLength = 0;
+  size_t pos = lineEnd;
+  while (pos != std::string::npos && pos < strHead.length()) {
+    size_t next = strHead.find("\r\n", pos + 2);
+    std::string strHeader = strHead.substr(pos + 2, next == std::string::npos ? std::string::npos : next - pos - 2);
+    size_t colon = strHeader.find(':');
+    if (colon != std::string::npos) {
+      std::string strName = strHeader.substr(0, colon);
+      std::string strValue = strHeader.substr(colon + 1);
+      strValue.erase(0, strValue.find_first_not_of(' '));
+      if (strcasecmp(strName.c_str(), "Content-Length") == 0) {
+        contentLength = strtoul(strValue.c_str(), NULL, 10);
+      } else if (strcasecmp(strName.c_str(), "Content-Type") == 0) {
+        request.contentType = strValue;
+      }
+    }
+    pos = next;
+  }
+
+  request.body = data.substr(headerEnd + 4);
+  request.body.reserve(contentLength);
+  while (request.body.length() < contentLength) {
+    ssize_t received = recv(client, buffer, std::min(sizeof(buffer), contentLength - request.body.length()), 0);
+    if (received <= 0) {
+      return false;
+    }
+    request.body.append(buffer, received);
+  }
+  return true;
+}
+
+// Store the file part of a multipart/form-data upload, as the ESP32 WebServer's upload handler does
+bool HandleUpload(int client, const Request& request, const char* file, const char* traceName, const char* what) {
+  size_t boundaryAt = request.contentType.find("boundary=");
+  size_t dataStart = request.body.find("\r\n\r\n");
+  if (boundaryAt == std::string::npos || dataStart == std::string::npos) {
+    printf("Error during %s upload\n", what);
+    SendJson(client, 500, std::string("{\"status\": \"error\", \"message\": \"") + (what[0] == 'b' ? "Binary" : "Payload") + " upload error\"}");
+    return false;
+  }
+  std::string strBoundary = "\r\n--" + request.contentType.substr(boundaryAt + 9);
+  dataStart += 4;
+  size_t dataEnd = request.body.find(strBoundary, dataStart);
+  if (dataEnd == std::string::npos) {
+    dataEnd = request.body.length();
+  }
+  size_t size = dataEnd - dataStart;
+
+  traceEvent(traceName, TRACE_BEGIN, 0);
+  std::string strPath = SpiffsPath(file);
+  remove(strPath.c_str());
+  printf("%c%s upload started: %zu bytes\n", toupper(what[0]), what + 1, size);
+
+  // A full SPIFFS fails the write
+  FILE* f = size <= uiSpiffsBytes - std::min(uiSpiffsBytes, SpiffsUsedBytes()) ? fopen(strPath.c_str(), "wb") : NULL;
+  if (!f || fwrite(request.body.data() + dataStart, 1, size, f) != size) {
+    if (f) {
+      fclose(f);
+    }
+    traceEvent(traceName, TRACE_END, 0);
+    printf("Failed to open %s file for writing\n", what);
+    SendJson(client, 500, std::string("{\"status\": \"error\", \"message\": \"Failed to open ") + what + " file\"}");
+    return false;
+  }
+  fclose(f);
+  traceEvent(traceName, TRACE_END, size);
+  printf("%c%s upload complete\n", toupper(what[0]), what + 1);
+  SendJson(client, 200, std::string("{\"status\": \"success\", \"message\": \"") + (what[0] == 'b' ? "Binary" : "Payload") + " upload complete\"}");
+  return true;
+}
+
+// Run the task in a child process, a crashing task takes down only itself
+void Execute(int client) {
+  if (bBusy) {
+    SendJson(client, 500, "{\"status\": \"busy\"}");
+    return;
+  }
+
+  // Mark busy from now
+  bBusy = true;
+  traceEvent("execute", TRACE_BEGIN, 0);
+
+  // Cleanup
+  remove(SpiffsPath(OUTPUT_FILE).c_str());
+
+  // Load the task and find its main function
+  Task_t task;
+  const char* error = NULL;
+  if (!LoadTask(&task, &error)) {
+    SendJson(client, 500, std::string("{\"status\": \"error\", \"message\": \"") + error + "\"}");
+    FreeTask(&task);
+    traceEvent("execute", TRACE_END, 1);
+    bBusy = false;
+    return;
+  }
+
+  // Respond with success message
+  SendJson(client, 200, "{\"status\": \"success\", \"message\": \"Task started\"}");
+  shutdown(client, SHUT_WR);
+
+  // Execute the function
+  fflush(stdout);
+  traceEvent("run", TRACE_BEGIN, strArgument.length());
+  auto start = std::chrono::steady_clock::now();
+  pid_t pid = fork();
+  if (pid == 0) {
+    task.func(strArgument.c_str(), strArgument.length());
+    fflush(NULL);
+    _exit(0);
+  }
+  int status = 0;
+  while (pid > 0 && waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // Take as long as the node being emulated would
+  if (dCpuScale > 1.0) {
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds * (dCpuScale - 1.0)));
+  }
+  traceEvent("run", TRACE_END, 0);
+
+  if (pid > 0 && WIFEXITED(status)) {
+    // Increment total executed tasks
+    uiTotalExecuted++;
+  } else {
+    printf("Task crashed (%s)\n", pid < 0 ? "fork failed" : WIFSIGNALED(status) ? strsignal(WTERMSIG(status)) : "exit");
+  }
+
+  // Clean up memory
+  FreeTask(&task);
+
+  // Mark as not busy
+  traceEvent("execute", TRACE_END, 0);
+  bBusy = false;
+}
+
+void Output(int client) {
+  // Stream the output file over HTTP
+  FILE* outputFile = fopen(SpiffsPath(OUTPUT_FILE).c_str(), "rb");
+  if (!outputFile) {
+    SendJson(client, 500, "{\"status\": \"error\", \"message\": \"Output file not found\"}");
+    return;
+  }
+
+  fseek(outputFile, 0, SEEK_END);
+  long size = ftell(outputFile);
+  fseek(outputFile, 0, SEEK_SET);
+  traceEvent("output", TRACE_BEGIN, size);
+
+  char header[160];
+  int length = snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: %ld\r\nConnection: close\r\n\r\n", size);
+  SendAll(client, header, length);
+  char buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), outputFile)) > 0 && SendAll(client, buffer, n)) {
+  }
+  fclose(outputFile);
+  traceEvent("output", TRACE_END, 0);
+}
+
+void Trace(int client) {
+  char buffer[96];
+  std::string strBody;
+  snprintf(buffer, sizeof(buffer), "{\"now\": %lld, \"dropped\": %u, \"events\": [", (long long)traceNow(), (unsigned)traceDropped());
+  strBody += buffer;
+  for (size_t n = 0; n < traceCount(); n++) {
+    const TraceEvent_t* event = traceAt(n);
+    snprintf(buffer, sizeof(buffer), "%s[%lld, \"%s\", \"%c\", %u]", n ? ", " : "", (long long)event->time, event->name, event->phase, (unsigned)event->value);
+    strBody += buffer;
+  }
+  strBody += "]}";
+  SendJson(client, 200, strBody);
+  traceClear();
+}
+
+void HandleClient(int client) {
+  Request request;
+  if (!ReadRequest(client, request)) {
+    close(client);
+    return;
+  }
+
+  if (request.path == "/execute") {
+    Execute(client);
+  } else if (request.path == "/uploadbin" && request.method == "POST") {
+    strArgument = "";
+    HandleUpload(client, request, BINARY_FILE, "binary_write", "binary");
+  } else if (request.path == "/uploadpayload" && request.method == "POST") {
+    strArgument = "";
+    HandleUpload(client, request, INPUT_FILE, "payload_write", "payload");
+  } else if (request.path == "/output") {
+    Output(client);
+  } else if (request.path == "/status") {
+    SendJson(client, 200, bBusy ? "{\"status\": \"busy\"}" : "{\"status\": \"available\"}");
+  } else if (request.path == "/arg") {
+    if (bBusy) {
+      SendJson(client, 200, "{\"status\": \"busy\"}");
+    } else {
+      strArgument = request.body;  // Store the argument
+      traceEvent("arg", TRACE_INSTANT, strArgument.length());
+      printf("Argument received: %s\n", strArgument.c_str());
+      SendJson(client, 200, "{\"status\": \"ok\", \"argument\": \"" + strArgument + "\"}");
+    }
+  } else if (request.path == "/clock") {
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "{\"now\": %lld}", (long long)traceNow());
+    SendJson(client, 200, buffer);
+  } else if (request.path == "/trace") {
+    Trace(client);
+  } else {
+    Send(client, 404, "text/plain", "Not found: " + request.path);
+  }
+  close(client);
+}
+
+void Usage(const char* name) {
+  printf("Usage: %s [options]\n"
+         "  -i ADDR    Address to serve and beacon from, e.g. 127.0.0.2 for a local cluster (default 127.0.0.1)\n"
+         "  -p PORT    HTTP port (default 80, the commander expects 80)\n"
+         "  -b ADDR    Beacon destination (default 255.255.255.255, use 127.0.0.1 for a commander on this host)\n"
+         "  -d DIR     Node directory, task files live in DIR/spiffs (default ./tessie_node_<addr>)\n"
+         "  -s BYTES   SPIFFS size (default %d)\n"
+         "  -c SCALE   Make tasks take SCALE times as long as on this host, to emulate slower nodes (default 1)\n"
+         "  -r RSSI    Signal strength to report (default -40)\n"
+         "  -t MS      Beacon interval in milliseconds (default %d)\n",
+         name, SPIFFS_BYTES, BROADCAST_TIMER);
+}
+
+int main(int argc, char** argv) {
+  std::string strDirectory;
+  int opt;
+  while ((opt = getopt(argc, argv, "i:p:b:d:s:c:r:t:h")) != -1) {
+    switch (opt) {
+      case 'i': strAddress = optarg; break;
+      case 'p': iHttpPort = atoi(optarg); break;
+      case 'b': strBroadcast = optarg; break;
+      case 'd': strDirectory = optarg; break;
+      case 's': uiSpiffsBytes = strtoul(optarg, NULL, 10); break;
+      case 'c': dCpuScale = atof(optarg); break;
+      case 'r': iRssi = atoi(optarg); break;
+      case 't': iBeaconMs = atoi(optarg); break;
+      default: Usage(argv[0]); return opt == 'h' ? 0 : 1;
+    }
+  }
+  if (strDirectory.empty()) {
+    strDirectory = "tessie_node_" + strAddress;
+  }
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  signal(SIGPIPE, SIG_IGN);
+
+  // Mount FS, start clean like the ESP32 does on boot
+  strSpiffs = strDirectory + "/spiffs";
+  mkdir(strDirectory.c_str(), 0755);
+  mkdir(strSpiffs.c_str(), 0755);
+  remove(SpiffsPath(BINARY_FILE).c_str());
+  remove(SpiffsPath(INPUT_FILE).c_str());
+  remove(SpiffsPath(OUTPUT_FILE).c_str());
+
+  // Init HTTP
+  int server = socket(AF_INET, SOCK_STREAM, 0);
+  int enable = 1;
+  setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(iHttpPort);
+  address.sin_addr.s_addr = inet_addr(strAddress.c_str());
+  if (bind(server, (sockaddr*)&address, sizeof(address)) != 0 || listen(server, 16) != 0) {
+    perror("Failed to start HTTP server");
+    return 1;
+  }
+  printf("Node %s serving on %s:%d from %s, CPU scale %.2f\n", MacAddress().c_str(), strAddress.c_str(), iHttpPort,
+         strSpiffs.c_str(), dCpuScale);
+
+  // Initialize advertisement timer
+  std::thread(BroadcastTimer).detach();
+
+  while (true) {
+    int client = accept(server, NULL, NULL);
+    if (client < 0) {
+      continue;
+    }
+    timeval timeout = { HTTP_MAX_DATA_WAIT, 0 };
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    HandleClient(client);
+  }
+}
@@ -84,7 +84,7 @@ base64 "${SOURCE_FILE_NAME}.elf" > "${SOURCE_FILE_NAME}.bin"
  
 echo "Build complete!"
 echo "Deploy task to GIT ${SOURCE_FILE_NAME}.bin"
-echo "Test the task with runner ${SOURCE_FILE_NAME}.hex"
+echo "Test the task natively with Node/Linux: make runner/${SOURCE_FILE_NAME}"
 echo "Send to tesselator ${SOURCE_FILE_NAME}.elf"
 
 ls -lha ${SOURCE_FILE_NAME}.*
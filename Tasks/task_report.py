@@ -0,0 +1,151 @@
+# Tesselator task report
+# https://github.com/invpe/Tesselator
+#
+# What a task costs a node before it runs: the bytes uploaded, the memory and allocations the ELF
+# loader makes for it (one per allocated section), its relocations by type and the symbols it imports.
+# Needs nothing but Python, so it reports on xtensa and riscv builds without their toolchains.
+#
+#   python3 task_report.py build/xtensa/*.elf
+import argparse
+import collections
+import struct
+import sys
+
+MACHINES = {94: "xtensa", 243: "riscv", 62: "x86_64"}
+
+SHT_SYMTAB, SHT_RELA, SHT_REL = 2, 4, 9
+SHF_ALLOC, SHF_EXECINSTR = 0x2, 0x4
+SHN_UNDEF = 0
+
+# Relocation types Node/ESP32/loader.cpp applies, anything else fails the load
+RELOCATIONS = {
+    "xtensa": {0: "R_XTENSA_NONE", 1: "R_XTENSA_32", 11: "R_XTENSA_ASM_EXPAND", 20: "R_XTENSA_SLOT0_OP"},
+    "riscv": {
+        0: "R_RISCV_NONE", 1: "R_RISCV_32", 16: "R_RISCV_BRANCH", 17: "R_RISCV_JAL", 18: "R_RISCV_CALL",
+        19: "R_RISCV_CALL_PLT", 20: "R_RISCV_GOT_HI20", 23: "R_RISCV_PCREL_HI20", 24: "R_RISCV_PCREL_LO12_I",
+        25: "R_RISCV_PCREL_LO12_S", 26: "R_RISCV_HI20", 27: "R_RISCV_LO12_I", 28: "R_RISCV_LO12_S",
+        33: "R_RISCV_ADD8", 34: "R_RISCV_ADD16", 35: "R_RISCV_ADD32", 37: "R_RISCV_SUB8", 38: "R_RISCV_SUB16",
+        39: "R_RISCV_SUB32", 43: "R_RISCV_ALIGN", 44: "R_RISCV_RVC_BRANCH", 45: "R_RISCV_RVC_JUMP",
+        51: "R_RISCV_RELAX", 52: "R_RISCV_SUB6", 53: "R_RISCV_SET6", 54: "R_RISCV_SET8", 55: "R_RISCV_SET16",
+        56: "R_RISCV_SET32", 57: "R_RISCV_32_PCREL",
+    },
+    "x86_64": {
+        0: "R_X86_64_NONE", 1: "R_X86_64_64", 2: "R_X86_64_PC32", 4: "R_X86_64_PLT32", 9: "R_X86_64_GOTPCREL",
+        10: "R_X86_64_32", 11: "R_X86_64_32S", 24: "R_X86_64_PC64", 41: "R_X86_64_GOTPCRELX",
+        42: "R_X86_64_REX_GOTPCRELX",
+    },
+}
+
+# Symbols the nodes export to tasks, see Node/ESP32/ESP32.ino and Node/Linux/tessie_node.cpp
+# On the ESP32 the ROM functions (memcpy, memset, ...) are resolved by the linker script instead
+ESP32_EXPORTS = {"puts", "printf", "fgets", "fread", "fwrite", "fopen", "fclose", "fprintf", "fseek", "ftell",
+                 "fflush", "fscanf", "fputs", "fputc", "putchar"}
+EXPORTS = {
+    "xtensa": ESP32_EXPORTS,
+    "riscv": ESP32_EXPORTS,
+    "x86_64": ESP32_EXPORTS | {"memcpy", "memset", "memmove", "memcmp", "__stack_chk_fail", "__isoc99_fscanf",
+                               "__isoc99_sscanf", "sscanf", "malloc", "calloc", "free", "frexp"},
+}
+
+class Section:
+    def __init__(self, name, kind, flags, offset, size, link, info, entsize):
+        self.name, self.kind, self.flags = name, kind, flags
+        self.offset, self.size, self.link, self.info, self.entsize = offset, size, link, info, entsize
+
+def read_elf(data):
+    """Machine and sections of a little-endian relocatable ELF file."""
+    if data[:4] != b"\x7fELF" or data[5] != 1:
+        raise ValueError("not a little-endian ELF file")
+    wide = data[4] == 2
+    machine, = struct.unpack_from("<H", data, 18)
+    if wide:
+        shoff, = struct.unpack_from("<Q", data, 40)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 58)
+        layout = "<IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from("<I", data, 32)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 46)
+        layout = "<IIIIIIIIII"
+    raw = [struct.unpack_from(layout, data, shoff + i * shentsize) for i in range(shnum)]
+    names = raw[shstrndx][4] if shnum else 0
+
+    def string(table, index):
+        start = table + index
+        return data[start:data.index(b"\0", start)].decode(errors="replace")
+
+    sections = []
+    for name, kind, flags, _, offset, size, link, info, _, entsize in raw:
+        sections.append(Section(string(names, name), kind, flags, offset, size, link, info, entsize))
+    return machine, wide, sections, string
+
+def report(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    machine, wide, sections, string = read_elf(data)
+    arch = MACHINES.get(machine, f"machine {machine}")
+    known = RELOCATIONS.get(arch, {})
+
+    allocated = [s for s in sections if s.flags & SHF_ALLOC and s.size]
+    code = sum(s.size for s in allocated if s.flags & SHF_EXECINSTR)
+    loaded = sum(s.size for s in allocated)
+
+    imports, defined = set(), set()
+    symtab = next((s for s in sections if s.kind == SHT_SYMTAB), None)
+    if symtab:
+        entry = "<IBBHQQ" if wide else "<IIIBBH"
+        for i in range(1, symtab.size // symtab.entsize):
+            fields = struct.unpack_from(entry, data, symtab.offset + i * symtab.entsize)
+            name, shndx = (fields[0], fields[3]) if wide else (fields[0], fields[5])
+            bind = (fields[1] if wide else fields[3]) >> 4
+            if not name:
+                continue
+            symbol = string(sections[symtab.link].offset, name)
+            if shndx == SHN_UNDEF:
+                imports.add(symbol)
+            elif bind:
+                defined.add(symbol)
+
+    relocations = collections.Counter()
+    for s in sections:
+        if s.kind in (SHT_RELA, SHT_REL) and s.entsize and sections[s.info].flags & SHF_ALLOC:
+            for i in range(s.size // s.entsize):
+                offset = s.offset + i * s.entsize
+                if wide:
+                    kind = struct.unpack_from("<Q", data, offset + 8)[0] & 0xffffffff
+                else:
+                    kind = struct.unpack_from("<I", data, offset + 4)[0] & 0xff
+                relocations[kind] += 1
+
+    print(f"{path} ({arch})")
+    print(f"  upload   {len(data)} bytes")
+    print(f"  loaded   {loaded} bytes in {len(allocated)} allocations, {code} bytes of code"
+          f" ({', '.join(f'{s.name} {s.size}' for s in allocated)})")
+    print(f"  relocs   {sum(relocations.values())}")
+    for kind, count in relocations.most_common():
+        name = known.get(kind)
+        print(f"    {count:6}  {name or f'type {kind}'}{'' if name else '  (not supported by the loader)'}")
+    missing = sorted(imports - EXPORTS.get(arch, set()))
+    print(f"  imports  {len(imports)}: {' '.join(sorted(imports)) or '-'}")
+    if "local_main" not in defined:
+        print("  error    local_main is not defined")
+    if missing:
+        print(f"  error    not exported by the node: {' '.join(missing)}")
+    return not missing and "local_main" in defined and all(kind in known for kind in relocations)
+
+def main():
+    parser = argparse.ArgumentParser(description="Upload size, loader allocations, relocations and imports of task builds")
+    parser.add_argument("files", nargs="+", metavar="ELF", help="task builds (relocatable ELF files)")
+    parser.add_argument("--strict", action="store_true", help="exit with 1 if a task would not load on a node")
+    args = parser.parse_args()
+
+    loadable = True
+    for path in args.files:
+        try:
+            loadable &= report(path)
+        except (OSError, ValueError, struct.error) as e:
+            print(f"{path}: {e}")
+            loadable = False
+    return 1 if args.strict and not loadable else 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,42 @@
+// Tessie batch task
+// Hashes every item of a batch (e.g. MAC addresses) with FNV-1a
+// Submit with: python3 tessie.py -b tessie_batch.elf -a "AA:BB:CC:DD:EE:FF" "11:22:33:44:55:66" ... --batch 500
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tessie_batch.h"
+
+uint32_t fnv1a(const char* data, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void local_main(const char* arg, size_t len) {
+    tessie_batch_t batch;
+    char item[64];
+    char result[16];
+    size_t item_len;
+
+    if (tessie_batch_open(&batch) != 0) {
+        return;
+    }
+    printf("Batch of %u items\n", batch.count);
+
+    while (tessie_batch_next(&batch, item, sizeof(item), &item_len)) {
+        uint32_t hash = fnv1a(item, item_len);
+
+        // Format the hash by hand, stdio formatting into a buffer isn't exported
+        for (int i = 0; i < 8; i++) {
+            result[i] = "0123456789abcdef"[(hash >> (28 - 4 * i)) & 0xf];
+        }
+        tessie_batch_emit(&batch, result, 8);
+    }
+
+    tessie_batch_close(&batch);
+    printf("Job done\n");
+}
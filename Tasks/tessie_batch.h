@@ -0,0 +1,108 @@
+// Tessie batch helpers
+// Lets one task execution process many small work items packed by the commander (`--batch N`)
+// Header only, uses nothing beyond the stdio functions the node already exports
+//
+// Input  /spiffs/task_input : "TSBT", uint32 count, count x (uint32 offset, uint32 length), item data
+// Output /spiffs/task_output: per item result, uint32 index, uint32 length, result data
+// All integers are little-endian, offsets are relative to the start of the item data
+#ifndef __TESSIE_BATCH__
+#define __TESSIE_BATCH__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TESSIE_BATCH_MAGIC "TSBT"
+
+typedef struct {
+    FILE* in;
+    FILE* out;
+    uint32_t count;   // Number of items in the batch
+    uint32_t index;   // Index of the item returned by the last tessie_batch_next
+    long data_start;  // File offset of the item data
+} tessie_batch_t;
+
+static inline uint32_t tessie_batch_get32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void tessie_batch_put32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+// Open the batch input and the output, returns 0 on success
+static inline int tessie_batch_open(tessie_batch_t* b) {
+    uint8_t header[8];
+
+    memset(b, 0, sizeof(*b));
+    b->index = (uint32_t)-1;
+
+    b->in = fopen("/spiffs/task_input", "r");
+    if (b->in == NULL) {
+        printf("Batch input not found\n");
+        return 1;
+    }
+
+    if (fread(header, 1, sizeof(header), b->in) != sizeof(header) || memcmp(header, TESSIE_BATCH_MAGIC, 4) != 0) {
+        printf("Input is not a batch\n");
+        fclose(b->in);
+        return 1;
+    }
+    b->count = tessie_batch_get32(header + 4);
+    b->data_start = sizeof(header) + 8L * b->count;
+
+    b->out = fopen("/spiffs/task_output", "w");
+    if (b->out == NULL) {
+        printf("Failed to open batch output\n");
+        fclose(b->in);
+        return 1;
+    }
+    return 0;
+}
+
+// Read the next item into buf (at most size bytes, NUL terminated when there is room)
+// Returns 1 with the item length in *len, 0 when all items were processed
+static inline int tessie_batch_next(tessie_batch_t* b, char* buf, size_t size, size_t* len) {
+    uint8_t entry[8];
+
+    if (++b->index >= b->count) {
+        return 0;
+    }
+
+    fseek(b->in, 8L + 8L * b->index, SEEK_SET);
+    if (fread(entry, 1, sizeof(entry), b->in) != sizeof(entry)) {
+        return 0;
+    }
+
+    uint32_t offset = tessie_batch_get32(entry);
+    uint32_t length = tessie_batch_get32(entry + 4);
+    if (length > size) {
+        length = size;
+    }
+
+    fseek(b->in, b->data_start + offset, SEEK_SET);
+    *len = fread(buf, 1, length, b->in);
+    if (*len < size) {
+        buf[*len] = 0;
+    }
+    return 1;
+}
+
+// Store the result of the current item
+static inline void tessie_batch_emit(tessie_batch_t* b, const void* data, size_t len) {
+    uint8_t header[8];
+    tessie_batch_put32(header, b->index);
+    tessie_batch_put32(header + 4, (uint32_t)len);
+    fwrite(header, 1, sizeof(header), b->out);
+    fwrite(data, 1, len, b->out);
+}
+
+static inline void tessie_batch_close(tessie_batch_t* b) {
+    fclose(b->in);
+    fclose(b->out);
+}
+
+#endif /* __TESSIE_BATCH__ */
@@ -0,0 +1,175 @@
+// Tessie benchmark task
+// Runs one benchmark of a node's performance profile, named in the argument with its iteration count,
+// e.g. "double 1000000". The commander times the run from the node's trace, see `tessie.py --bench`
+//
+//   int32    COUNT x 4 int32 multiply-add/xorshift steps
+//   float    COUNT x 8 single precision multiply-adds
+//   double   COUNT x 8 double precision multiply-adds
+//   memory   COUNT copies of an 8 KB buffer
+//   spiffs_w COUNT KB written to SPIFFS in 1 KB blocks
+//   spiffs_r the payload read from SPIFFS in 1 KB blocks, COUNT times
+//   stdio    COUNT lines formatted with fprintf("%d %f\n")
+//   empty    nothing, the run measures the loader alone
+//
+// Every benchmark stores a checksum in the output, so its work cannot be optimized away
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MEMORY_BYTES 8192
+#define BLOCK_BYTES 1024
+
+static uint32_t memory_src[MEMORY_BYTES / 4], memory_dst[MEMORY_BYTES / 4];
+static uint8_t block[BLOCK_BYTES];
+
+uint32_t bench_int32(uint32_t count) {
+    uint32_t a = 1, b = 2, c = 3, d = 4;
+    for (uint32_t i = 0; i < count; i++) {
+        a = a * 1664525u + 1013904223u;
+        b ^= b << 13;
+        b ^= b >> 17;
+        b ^= b << 5;
+        c = c * 22695477u + a;
+        d += (b >> 3) ^ c;
+    }
+    return a ^ b ^ c ^ d;
+}
+
+float bench_float(uint32_t count) {
+    float x[8] = { 1.0f, 1.1f, 1.2f, 1.3f, 1.4f, 1.5f, 1.6f, 1.7f };
+    for (uint32_t i = 0; i < count; i++) {
+        for (int k = 0; k < 8; k++) {
+            x[k] = x[k] * 0.999f + 0.001f;
+        }
+    }
+    return x[0] + x[1] + x[2] + x[3] + x[4] + x[5] + x[6] + x[7];
+}
+
+double bench_double(uint32_t count) {
+    double x[8] = { 1.0, 1.1, 1.2, 1.3, 1.4, 1.5, 1.6, 1.7 };
+    for (uint32_t i = 0; i < count; i++) {
+        for (int k = 0; k < 8; k++) {
+            x[k] = x[k] * 0.999 + 0.001;
+        }
+    }
+    return x[0] + x[1] + x[2] + x[3] + x[4] + x[5] + x[6] + x[7];
+}
+
+uint32_t bench_memory(uint32_t count) {
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        // Touch the source so every copy is a new one
+        memory_src[i % (MEMORY_BYTES / 4)] = i;
+        memcpy(memory_dst, memory_src, MEMORY_BYTES);
+        sum += memory_dst[(i * 7) % (MEMORY_BYTES / 4)];
+    }
+    return sum;
+}
+
+uint32_t bench_spiffs_write(uint32_t count) {
+    FILE* file = fopen("/spiffs/bench_scratch", "w");
+    if (!file) {
+        printf("Failed to open the scratch file\n");
+        return 0;
+    }
+    uint32_t written = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        block[i % BLOCK_BYTES] = (uint8_t)i;
+        written += fwrite(block, 1, BLOCK_BYTES, file);
+    }
+    fclose(file);
+
+    // Leave no scratch data behind, SPIFFS space is short
+    file = fopen("/spiffs/bench_scratch", "w");
+    if (file) {
+        fclose(file);
+    }
+    return written;
+}
+
+uint32_t bench_spiffs_read(uint32_t count) {
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        FILE* file = fopen("/spiffs/task_input", "r");
+        if (!file) {
+            printf("Failed to open the payload\n");
+            return 0;
+        }
+        size_t n;
+        while ((n = fread(block, 1, BLOCK_BYTES, file)) > 0) {
+            sum += block[n - 1] + n;
+        }
+        fclose(file);
+    }
+    return sum;
+}
+
+uint32_t bench_stdio(uint32_t count) {
+    FILE* file = fopen("/spiffs/bench_scratch", "w");
+    if (!file) {
+        printf("Failed to open the scratch file\n");
+        return 0;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        fprintf(file, "%d %f\n", (int)i, i * 0.001);
+    }
+    long size = ftell(file);
+    fclose(file);
+
+    file = fopen("/spiffs/bench_scratch", "w");
+    if (file) {
+        fclose(file);
+    }
+    return (uint32_t)size;
+}
+
+int same(const char* a, const char* b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+void local_main(const char* arg, size_t len) {
+    char name[16];
+    size_t n = 0;
+    uint32_t count = 0;
+
+    // "<name> <count>"
+    while (n < len && n < sizeof(name) - 1 && arg[n] != ' ') {
+        name[n] = arg[n];
+        n++;
+    }
+    name[n] = '\0';
+    for (size_t i = n + 1; i < len && arg[i] >= '0' && arg[i] <= '9'; i++) {
+        count = count * 10 + (uint32_t)(arg[i] - '0');
+    }
+
+    double check = 0;
+    if (same(name, "int32")) {
+        check = bench_int32(count);
+    } else if (same(name, "float")) {
+        check = bench_float(count);
+    } else if (same(name, "double")) {
+        check = bench_double(count);
+    } else if (same(name, "memory")) {
+        check = bench_memory(count);
+    } else if (same(name, "spiffs_w")) {
+        check = bench_spiffs_write(count);
+    } else if (same(name, "spiffs_r")) {
+        check = bench_spiffs_read(count);
+    } else if (same(name, "stdio")) {
+        check = bench_stdio(count);
+    } else if (!same(name, "empty")) {
+        printf("Unknown benchmark %s\n", name);
+        return;
+    }
+
+    FILE* output_file = fopen("/spiffs/task_output", "w");
+    if (output_file) {
+        fprintf(output_file, "# %s %u = %f\n", name, (unsigned)count, check);
+        fclose(output_file);
+    }
+}
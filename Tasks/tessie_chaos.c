@@ -1,226 +1,418 @@
-/*
-    The Tesselator task applies Delayed Space Coordinates (DSC) transformation to a dataset, 
-    projecting the resulting points into a 2D grid and calculating entropy.
-    It ties to my speculative researches i always like doing.
-
-    The steps are as follows:
-    0. The dataset is firstly read for min/max values for normalization later on
-    1. The dataset is read in chunks, and for each chunk, a DSC transformation maps the data points into 3D space.
-    2. The 3D points (x, y, z) are normalized to the range [0, 1] based on the minimum and maximum values of the dataset.
-    3. These points are then projected onto a 2D grid of size GRID_SIZE x GRID_SIZE (e.g., 10x10), where the x and y coordinates are used for binning, while the z-axis (depth) is ignored.
-    4. The Y-axis is inverted during binning to follow the top-down coordinate system, with higher Y-values at the top of the grid.
-    5. The grid represents a 2D projection, where each cell counts the number of points that fall into it.
-    6. The final bin counts are used to estimate clustering or randomness in the dataset using entropy calculation.
-
-    The mapping logic:
-    - The x and y coordinates are scaled from [-1, 1] to fit the grid, dynamically adjusting based on GRID_SIZE.
-    - Each grid cell accumulates the number of points within its region, ignoring the z-depth (projection).
-    - The Y-axis is inverted to align with typical top-left origin visualization.
-    - For example, the top-left bin represents (-GRID_SIZE/2, GRID_SIZE/2) in x, y space, and the bottom-right bin represents (GRID_SIZE/2, -GRID_SIZE/2).
-
-    Entropy Calculation:
-    - Entropy is calculated to analyze the randomness or clustering of the dataset.
-    - A higher entropy value indicates more randomness, while a lower entropy suggests clustering.
-    - The entropy result can help determine whether a dataset is worth further visual inspection or if it exhibits random patterns.
-
-    The main purpose of this task is to detect and analyze clustering in the dataset by visualizing the density of points.
-    
-    The visualization tool that comes as bundle for this task uses OpenGL for rendering the DSC data in 3D space
-    Important: no more than 10k of inputs per dataset is suggested
-*/
-#include <stdio.h>
-#include <stdint.h>
-#include <stdlib.h>
-#include <float.h> 
-#include <math.h>
-
-#define GRID_SIZE 10  // Defines a 10x10 grid for x and y axes
-
-// Global bins for 2D projection (x, y)
-int bins[GRID_SIZE][GRID_SIZE] = {0}; 
-int iTotalPointsCount = 0;
-
-double iMinValue, iMaxValue;
-
-
-struct tPosition {
-    double x;
-    double y;
-    double z;
-};
-  
-double fast_log2(double x) {
-    int exp;
-    double frac = frexp(x, &exp); // Separate the exponent and fraction
-    return exp + (frac - 1.0); // Approximation
-}
-
-void calculate_2D_bin(struct tPosition pos) {
-    // Scale pos.x and pos.y from [-1, 1] to [0, GRID_SIZE - 1] range for binning
-    double scale_factor = (double)(GRID_SIZE / 2);
-    double grid_x = pos.x * scale_factor;  // Scale from [-1, 1] to [-GRID_SIZE/2, GRID_SIZE/2]
-    double grid_y = pos.y * scale_factor;  // Scale from [-1, 1] to [-GRID_SIZE/2, GRID_SIZE/2]
-
-    // Calculate bin index (scale to the range [0, GRID_SIZE-1] from [-GRID_SIZE/2, GRID_SIZE/2])
-    int x_bin = (int)((grid_x + (GRID_SIZE / 2.0)));  // Offset by half of GRID_SIZE to shift into [0, GRID_SIZE-1]
-    int y_bin = (int)((-grid_y + (GRID_SIZE / 2.0)));  // Invert Y-axis for top-down grid orientation
-
-    // Ensure bin indices are within valid range [0, GRID_SIZE-1]
-    if (x_bin >= GRID_SIZE) x_bin = GRID_SIZE - 1;
-    if (y_bin >= GRID_SIZE) y_bin = GRID_SIZE - 1;
-    if (x_bin < 0) x_bin = 0;
-    if (y_bin < 0) y_bin = 0;
-
-    // Increment the count in the corresponding 2D bin
-    bins[x_bin][y_bin]++;
-}
-
-// Function to process a chunk of data, calculate DSC, and count points in 2D bins
-int ProcessChunkAnd2DBin(double* buffer, size_t buffer_size,FILE *fp) {
-    
-
-    struct tPosition pos;
-    // Calculate DSC and normalize for all but the first 3 elements (which don't have full history)
-    for (size_t a = 3; a < buffer_size; a++) {
-
-        pos.x = buffer[a] - buffer[a - 1];
-        pos.y = buffer[a - 1] - buffer[a - 2];
-        pos.z = buffer[a - 2] - buffer[a - 3];
-
-        // Normalize to the range [0, 1]
-        pos.x = (pos.x - iMinValue) / (iMaxValue - iMinValue);
-        pos.y = (pos.y - iMinValue) / (iMaxValue - iMinValue);
-        pos.z = (pos.z - iMinValue) / (iMaxValue - iMinValue);
-
-        //
-        fprintf(fp, "x=%lf, y=%lf, z=%lf\n", pos.x, pos.y, pos.z);
-
-        // Calculate the 2D bin (ignoring z-axis)
-        calculate_2D_bin(pos);
-
-        iTotalPointsCount++;
-    }
-
-    return 0;
-}
-int FindGlobalMinMax(const char* filename)
-{
-    FILE* input_file = fopen(filename, "r");
-    if (!input_file) {
-        printf("Failed to open the file.\n");
-        return 1;
-    }
-
-    double number;
-    iMaxValue = -DBL_MAX;
-    iMinValue = DBL_MAX;
-
-    // First pass to find global min/max
-    while (fscanf(input_file, "%lf", &number) == 1) {
-        if (number < iMinValue) iMinValue = number;
-        if (number > iMaxValue) iMaxValue = number;
-    }
-
-    fclose(input_file);
-
-    printf("Global Min: %lf, Global Max: %lf\n", iMinValue, iMaxValue);
-    return 0;
-}
-
-// Function to load the data file in chunks, calculate DSC, and bin points in 2D
-// Preserving the Last 3 Elements: The buffer moves the last 3 elements to the front after each chunk is processed to ensure continuity for the DSC calculation.
-int LoadFileInChunksAnd2DBin(const char* arg, const char* filename, const char* output_filename, size_t chunk_size)
-{
-    FILE* input_file = fopen(filename, "r");
-    if (!input_file) {
-        printf("Failed to open the file.\n");
-        return 1;
-    }
-
-    FILE* output_file = fopen(output_filename, "w");
-    if (!output_file) {
-        printf("Failed to open the output file.\n");
-        fclose(input_file);
-        return 1;
-    }
-
-    size_t buffer_size = chunk_size + 3;  // 3 extra slots for DSC history
-    double* buffer = (double*)malloc(buffer_size * sizeof(double));
-    if (!buffer) {
-        printf("Memory allocation failed.\n");
-        fclose(input_file);
-        fclose(output_file);
-        return 1;
-    }
-
-    size_t count = 0;
-    size_t chunk_index = 0;
-    double number;
-
-    // Read data in chunks and process with global min/max
-    while (fscanf(input_file, "%lf", &number) == 1) {
-        buffer[count++] = number;
-
-        // When the buffer is full, process it
-        if (count == buffer_size) {
-            printf("Processing chunk %zu\n", chunk_index);
-            ProcessChunkAnd2DBin(buffer, buffer_size, output_file);
-            chunk_index++;
-
-            // Move the last 3 elements to the front of the buffer for the next chunk
-            buffer[0] = buffer[buffer_size - 3];
-            buffer[1] = buffer[buffer_size - 2];
-            buffer[2] = buffer[buffer_size - 1];
-
-            count = 3;  // Reset count to continue filling the buffer, preserving last 3 points
-        }
-    }
-
-    // Process any remaining data
-    if (count > 3) {
-        ProcessChunkAnd2DBin(buffer, count, output_file);
-    }
-
-    double entropy = 0.0;
-
-    // Print out the 2D bin counts to the output file with corresponding [-5,5] labeling
-    for (int i = 0; i < GRID_SIZE; i++) {
-        for (int j = 0; j < GRID_SIZE; j++) {
-            int x_label = i - (GRID_SIZE / 2);  // Convert bin index to the range [-5, 5]
-            int y_label = j - (GRID_SIZE / 2);  // Convert bin index to the range [-5, 5]
-            fprintf(output_file, "# Bin (%d, %d): Points = %d\n", x_label, y_label, bins[i][j]);
-
-            // Calculate entropy 
-            if (bins[i][j] > 0) {
-                double p = (double)bins[i][j] / iTotalPointsCount;
-                entropy -= p * fast_log2(p);
-            }            
-        }
-    }
-
-    fprintf(output_file, "# Entropy = %f\n", entropy);
-    fprintf(output_file, "# Argument = %s\n", arg);
-    fprintf(output_file, "# Total = %i\n", iTotalPointsCount);
-    fprintf(output_file, "# Min = %lf\n", iMinValue);
-    fprintf(output_file, "# Max = %lf\n", iMaxValue);
-
-
-    // Clean up
-    free(buffer);
-    fclose(input_file);
-    fclose(output_file);
-
-    return 0;
-}
-
-void local_main(const char* arg, size_t len) {
-    printf("Starting task\n");
-    
-    // First pass to find the global min and max
-    FindGlobalMinMax("/spiffs/task_input");
-
-    // Process 50 chunks of raw data at once (mem safe)
-    LoadFileInChunksAnd2DBin(arg,"/spiffs/task_input", "/spiffs/task_output",100);
-
-    printf("Job done\n");
-}
+/*
+    The Tesselator task applies Delayed Space Coordinates (DSC) transformation to a dataset, 
+    projecting the resulting points into a 2D grid and calculating entropy.
+    It ties to my speculative researches i always like doing.
+
+    The steps are as follows:
+    0. The dataset is read once, tracking the min/max values for normalization and keeping the samples in memory
+       (with the min/max passed in the argument, e.g. "min=-3.5 max=4.2" for a shard, nothing is kept).
+       The points of samples beyond KEEP_SAMPLES are pre-binned on a FINE_GRID x FINE_GRID grid as they are read,
+       with cell edges on the bin edges of the min/max so far, and re-binned once min/max are known. That is exact
+       when min/max do not move after the kept samples; when they do, the points of a cell across a bin edge are
+       shared among the bins by area, so a few points near the edges may land in the neighbouring bin.
+    1. Once min/max are known, a DSC transformation maps the data points into 3D space.
+    2. The 3D points (x, y, z) are normalized to the range [0, 1] based on the minimum and maximum values of the dataset.
+    3. These points are then projected onto a 2D grid of size GRID_SIZE x GRID_SIZE (e.g., 10x10), where the x and y coordinates are used for binning, while the z-axis (depth) is ignored.
+    4. The Y-axis is inverted during binning to follow the top-down coordinate system, with higher Y-values at the top of the grid.
+    5. The grid represents a 2D projection, where each cell counts the number of points that fall into it.
+    6. The final bin counts are used to estimate clustering or randomness in the dataset using entropy calculation.
+
+    The mapping logic:
+    - The x and y coordinates are scaled from [-1, 1] to fit the grid, dynamically adjusting based on GRID_SIZE.
+    - Each grid cell accumulates the number of points within its region, ignoring the z-depth (projection).
+    - The Y-axis is inverted to align with typical top-left origin visualization.
+    - For example, the top-left bin represents (-GRID_SIZE/2, GRID_SIZE/2) in x, y space, and the bottom-right bin represents (GRID_SIZE/2, -GRID_SIZE/2).
+
+    Entropy Calculation:
+    - Entropy is calculated to analyze the randomness or clustering of the dataset.
+    - A higher entropy value indicates more randomness, while a lower entropy suggests clustering.
+    - The entropy result can help determine whether a dataset is worth further visual inspection or if it exhibits random patterns.
+
+    The main purpose of this task is to detect and analyze clustering in the dataset by visualizing the density of points.
+    
+    The visualization tool that comes as bundle for this task uses OpenGL for rendering the DSC data in 3D space,
+    it needs the per point "x=, y=, z=" lines written only with "points" in the argument, for the samples kept
+    in memory, or for all of them when min/max are given. When samples were pre-binned, a "# Points:" line after the
+    listed points tells how many were left out
+    Important: no more than 10k of inputs per dataset is suggested
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h> 
+#include <math.h>
+#include "tessie_io.h"
+
+#define GRID_SIZE 10  // Defines a 10x10 grid for x and y axes
+#ifndef KEEP_SAMPLES
+#define KEEP_SAMPLES 8192  // Most samples kept in memory until the global min/max are known (64 KB)
+#endif
+#ifndef FINE_GRID
+#define FINE_GRID 64  // Cells per axis of the pre-binning of the samples beyond KEEP_SAMPLES (16 KB), a multiple of 4
+#endif
+#define FINE_SPLIT 6  // Cells per bin to begin with, FINE_GRID must exceed GRID_SIZE * FINE_SPLIT
+
+// Global bins for 2D projection (x, y)
+int bins[GRID_SIZE][GRID_SIZE] = {0}; 
+int iTotalPointsCount = 0;
+
+double iMinValue, iMaxValue;
+
+// Block buffer for parsing the input, fscanf on SPIFFS is several times slower
+static char input_buffer[4096];
+
+
+struct tPosition {
+    double x;
+    double y;
+    double z;
+};
+  
+double fast_log2(double x) {
+    int exp;
+    double frac = frexp(x, &exp); // Separate the exponent and fraction
+    return exp + (frac - 1.0); // Approximation
+}
+
+void calculate_2D_bin(struct tPosition pos) {
+    // Scale pos.x and pos.y from [-1, 1] to [0, GRID_SIZE - 1] range for binning
+    double scale_factor = (double)(GRID_SIZE / 2);
+    double grid_x = pos.x * scale_factor;  // Scale from [-1, 1] to [-GRID_SIZE/2, GRID_SIZE/2]
+    double grid_y = pos.y * scale_factor;  // Scale from [-1, 1] to [-GRID_SIZE/2, GRID_SIZE/2]
+
+    // Calculate bin index (scale to the range [0, GRID_SIZE-1] from [-GRID_SIZE/2, GRID_SIZE/2])
+    int x_bin = (int)((grid_x + (GRID_SIZE / 2.0)));  // Offset by half of GRID_SIZE to shift into [0, GRID_SIZE-1]
+    int y_bin = (int)((-grid_y + (GRID_SIZE / 2.0)));  // Invert Y-axis for top-down grid orientation
+
+    // Ensure bin indices are within valid range [0, GRID_SIZE-1]
+    if (x_bin >= GRID_SIZE) x_bin = GRID_SIZE - 1;
+    if (y_bin >= GRID_SIZE) y_bin = GRID_SIZE - 1;
+    if (x_bin < 0) x_bin = 0;
+    if (y_bin < 0) y_bin = 0;
+
+    // Increment the count in the corresponding 2D bin
+    bins[x_bin][y_bin]++;
+}
+
+// Options of a run, from the task argument
+struct tOptions {
+    int bHaveMin, bHaveMax;  // Global min/max given, e.g. by the commander for a shard of a larger input
+    double fMin, fMax;
+    int bPoints;             // Write every normalized point, for the visualization tool
+};
+
+// The last 3 samples, the history a DSC point is built from
+double history[3];
+size_t iSamplesSeen = 0;
+
+// Take the next sample of the series, bin the DSC point it completes
+void AddSample(double sample, FILE* points_file) {
+    if (iSamplesSeen >= 3) {
+        struct tPosition pos;
+        pos.x = sample - history[2];
+        pos.y = history[2] - history[1];
+        pos.z = history[1] - history[0];
+
+        // Normalize to the range [0, 1]
+        pos.x = (pos.x - iMinValue) / (iMaxValue - iMinValue);
+        pos.y = (pos.y - iMinValue) / (iMaxValue - iMinValue);
+        pos.z = (pos.z - iMinValue) / (iMaxValue - iMinValue);
+
+        if (points_file) {
+            fprintf(points_file, "x=%lf, y=%lf, z=%lf\n", pos.x, pos.y, pos.z);
+        }
+
+        // Calculate the 2D bin (ignoring z-axis)
+        calculate_2D_bin(pos);
+
+        iTotalPointsCount++;
+    }
+    history[0] = history[1];
+    history[1] = history[2];
+    history[2] = sample;
+    iSamplesSeen++;
+}
+
+// Arguments are space separated: "min=<value> max=<value>" to bin while reading, "points" for per point output
+void ParseOptions(const char* arg, size_t len, struct tOptions* options) {
+    const char* end = arg + len;
+    const char* p = arg;
+    options->bHaveMin = options->bHaveMax = options->bPoints = 0;
+
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == ',')) p++;
+        const char* token = p;
+        while (p < end && *p != ' ' && *p != ',') p++;
+        size_t n = p - token;
+
+        if (n == 6 && memcmp(token, "points", 6) == 0) {
+            options->bPoints = 1;
+        } else if (n > 4 && memcmp(token, "min=", 4) == 0) {
+            options->bHaveMin = tessie_parse_double(token + 4, p, &options->fMin) == p;
+        } else if (n > 4 && memcmp(token, "max=", 4) == 0) {
+            options->bHaveMax = tessie_parse_double(token + 4, p, &options->fMax) == p;
+        }
+    }
+}
+
+// Pre-binning of the DSC points of the samples beyond the kept ones, by their x and y before normalization.
+// The cells cover [fine_lo, fine_lo + FINE_GRID * fine_cell) on both axes. They start out FINE_SPLIT to a bin of
+// the min/max known when the pre-binning begins, edge on edge, and get twice as wide when a point falls outside
+uint32_t (*fine_bins)[FINE_GRID] = NULL;
+double fine_lo, fine_cell;
+
+// Halve the resolution of a row or column of FINE_GRID cells, `stride` apart, in place: cell i goes to
+// i / 2 + FINE_GRID / 4, so the cells keep covering the same values over a range twice as wide
+void WidenFineCells(uint32_t* cells, size_t stride) {
+    for (int n = FINE_GRID / 2 - 1; n >= FINE_GRID / 4; n--) {  // Downwards, the sources are at or below n
+        int i = 2 * n - FINE_GRID / 2;
+        cells[n * stride] = cells[i * stride] + cells[(i + 1) * stride];
+    }
+    for (int n = FINE_GRID / 2; n < 3 * FINE_GRID / 4; n++) {  // Upwards, the sources are at or above n
+        int i = 2 * n - FINE_GRID / 2;
+        cells[n * stride] = cells[i * stride] + cells[(i + 1) * stride];
+    }
+    for (int n = 0; n < FINE_GRID / 4; n++) {
+        cells[n * stride] = cells[(FINE_GRID - 1 - n) * stride] = 0;
+    }
+}
+
+void StartFineBins(double min, double max) {
+    // The differences of samples lie within [-range, range]: cover it, with cell edges on the edges of the bins
+    double range = max > min ? max - min : 1.0;
+    double first_edge = min - range;  // x = (d - min) / range is -1 here, a bin edge follows every range / (GRID_SIZE / 2)
+    fine_cell = range / (GRID_SIZE / 2) / FINE_SPLIT;
+    long steps = (long)((-range - first_edge) / fine_cell);
+    if (first_edge + steps * fine_cell > -range) {
+        steps--;
+    }
+    fine_lo = first_edge + steps * fine_cell;
+}
+
+int FineCell(double v) {
+    double cell = (v - fine_lo) / fine_cell;
+    return cell < 0 ? 0 : cell < FINE_GRID ? (int)cell : FINE_GRID - 1;
+}
+
+// Count the DSC point of a sample beyond the kept ones, given the two samples before it
+void AddFineSample(double sample, double previous, double before_previous) {
+    double x = sample - previous;
+    double y = previous - before_previous;
+    for (;;) {
+        double hi = fine_lo + FINE_GRID * fine_cell;
+        if ((x >= fine_lo && x < hi && y >= fine_lo && y < hi) || fine_cell > DBL_MAX / (2 * FINE_GRID)) {
+            break;
+        }
+        for (int i = 0; i < FINE_GRID; i++) {
+            WidenFineCells(fine_bins[i], 1);
+        }
+        for (int j = 0; j < FINE_GRID; j++) {
+            WidenFineCells(&fine_bins[0][j], FINE_GRID);
+        }
+        fine_lo -= FINE_GRID / 2 * fine_cell;
+        fine_cell *= 2;
+    }
+    fine_bins[FineCell(x)][FineCell(y)]++;
+}
+
+// Share of the values [lo, hi) in each bin along an axis, mapped as calculate_2D_bin does, y inverted
+void FineShares(double lo, double hi, int invert, double share[GRID_SIZE]) {
+    double scale = (GRID_SIZE / 2) / (iMaxValue - iMinValue);
+    double a = (lo - iMinValue) * scale, b = (hi - iMinValue) * scale;
+    if (invert) {
+        double t = -b;
+        b = -a;
+        a = t;
+    }
+    a += GRID_SIZE / 2.0;
+    b += GRID_SIZE / 2.0;
+    for (int k = 0; k < GRID_SIZE; k++) {
+        double from = k == 0 ? -DBL_MAX : k, to = k == GRID_SIZE - 1 ? DBL_MAX : k + 1;
+        double overlap = (b < to ? b : to) - (a > from ? a : from);
+        share[k] = overlap > 0 ? overlap / (b - a) : 0;
+    }
+}
+
+// Move the pre-binned points into the bins, the points of a cell shared among the bins it overlaps by area
+void RebinFineSamples() {
+    static double spread[GRID_SIZE][GRID_SIZE];
+    double share_x[GRID_SIZE], share_y[GRID_SIZE];
+    long total = 0;
+    memset(spread, 0, sizeof(spread));
+    for (int i = 0; i < FINE_GRID; i++) {
+        FineShares(fine_lo + i * fine_cell, fine_lo + (i + 1) * fine_cell, 0, share_x);
+        for (int j = 0; j < FINE_GRID; j++) {
+            if (fine_bins[i][j] == 0) {
+                continue;
+            }
+            FineShares(fine_lo + j * fine_cell, fine_lo + (j + 1) * fine_cell, 1, share_y);
+            for (int x = 0; x < GRID_SIZE; x++) {
+                if (share_x[x] == 0) {
+                    continue;
+                }
+                for (int y = 0; y < GRID_SIZE; y++) {
+                    spread[x][y] += fine_bins[i][j] * share_x[x] * share_y[y];
+                }
+            }
+            total += fine_bins[i][j];
+        }
+    }
+
+    // Whole points: each bin its share rounded down, the points left over to the largest remainders
+    long left = total;
+    for (int x = 0; x < GRID_SIZE; x++) {
+        for (int y = 0; y < GRID_SIZE; y++) {
+            int whole = (int)spread[x][y];
+            bins[x][y] += whole;
+            spread[x][y] -= whole;
+            left -= whole;
+        }
+    }
+    for (; left > 0; left--) {
+        int bx = 0, by = 0;
+        for (int x = 0; x < GRID_SIZE; x++) {
+            for (int y = 0; y < GRID_SIZE; y++) {
+                if (spread[x][y] > spread[bx][by]) {
+                    bx = x;
+                    by = y;
+                }
+            }
+        }
+        bins[bx][by]++;
+        spread[bx][by] = -1;
+    }
+    iTotalPointsCount += total;
+}
+
+// Read the input once, derive the global min/max on the way and bin the DSC points
+// The samples are kept in memory until min/max are known, those beyond what the memory allows are pre-binned
+// finely as they come and re-binned at the end. With min/max given the points are binned as they are read
+int LoadFileAnd2DBin(const char* filename, FILE* points_file, const struct tOptions* options)
+{
+    tessie_reader_t input;
+    if (tessie_reader_open(&input, filename, input_buffer, sizeof(input_buffer)) != 0) {
+        return 1;
+    }
+
+    double number;
+    if (options->bHaveMin && options->bHaveMax) {
+        iMinValue = options->fMin;
+        iMaxValue = options->fMax;
+        while (tessie_read_double(&input, &number)) {
+            AddSample(number, points_file);
+        }
+        tessie_reader_close(&input);
+        return 0;
+    }
+
+    // Keep as many samples as the heap gives, up to KEEP_SAMPLES
+    size_t keep = KEEP_SAMPLES;
+    double* samples = NULL;
+    while (keep >= 64 && (samples = (double*)malloc(keep * sizeof(double))) == NULL) {
+        keep /= 2;
+    }
+    if (!samples) {
+        printf("Memory allocation failed.\n");
+        tessie_reader_close(&input);
+        return 1;
+    }
+
+    size_t count = 0;
+    double previous = 0, before_previous = 0;  // The samples before the current one, once the kept ones are full
+    iMaxValue = -DBL_MAX;
+    iMinValue = DBL_MAX;
+    while (tessie_read_double(&input, &number)) {
+        if (number < iMinValue) iMinValue = number;
+        if (number > iMaxValue) iMaxValue = number;
+        if (count < keep) {
+            samples[count] = number;
+        } else {
+            if (fine_bins == NULL) {
+                fine_bins = (uint32_t(*)[FINE_GRID])calloc(FINE_GRID, sizeof(*fine_bins));
+                if (!fine_bins) {
+                    printf("Memory allocation failed.\n");
+                    free(samples);
+                    tessie_reader_close(&input);
+                    return 1;
+                }
+                printf("Input exceeds %zu samples, pre-binning the rest\n", keep);
+                StartFineBins(iMinValue, iMaxValue);
+                previous = samples[keep - 1];
+                before_previous = samples[keep - 2];
+            }
+            AddFineSample(number, previous, before_previous);
+            before_previous = previous;
+            previous = number;
+        }
+        count++;
+    }
+    tessie_reader_close(&input);
+    printf("Global Min: %lf, Global Max: %lf\n", iMinValue, iMaxValue);
+
+    if (fine_bins != NULL) {
+        RebinFineSamples();
+        free(fine_bins);
+        fine_bins = NULL;
+    }
+
+    for (size_t i = 0; i < count && i < keep; i++) {
+        AddSample(samples[i], points_file);
+    }
+    if (points_file && count > keep) {
+        // The pre-binned points are only counted, say so rather than let the listing pass for all of them
+        fprintf(points_file, "# Points: only those of the first %zu of %zu samples are listed, "
+                             "pass min= and max= to list all\n", keep, count);
+    }
+    free(samples);
+    return 0;
+}
+
+int Write2DBins(const char* arg, FILE* output_file)
+{
+    double entropy = 0.0;
+
+    // Print out the 2D bin counts to the output file with corresponding [-5,5] labeling
+    for (int i = 0; i < GRID_SIZE; i++) {
+        for (int j = 0; j < GRID_SIZE; j++) {
+            int x_label = i - (GRID_SIZE / 2);  // Convert bin index to the range [-5, 5]
+            int y_label = j - (GRID_SIZE / 2);  // Convert bin index to the range [-5, 5]
+            fprintf(output_file, "# Bin (%d, %d): Points = %d\n", x_label, y_label, bins[i][j]);
+
+            // Calculate entropy 
+            if (bins[i][j] > 0) {
+                double p = (double)bins[i][j] / iTotalPointsCount;
+                entropy -= p * fast_log2(p);
+            }            
+        }
+    }
+
+    fprintf(output_file, "# Entropy = %f\n", entropy);
+    fprintf(output_file, "# Argument = %s\n", arg);
+    fprintf(output_file, "# Total = %i\n", iTotalPointsCount);
+    fprintf(output_file, "# Min = %lf\n", iMinValue);
+    fprintf(output_file, "# Max = %lf\n", iMaxValue);
+
+    return 0;
+}
+
+void local_main(const char* arg, size_t len) {
+    printf("Starting task\n");
+
+    struct tOptions options;
+    ParseOptions(arg, len, &options);
+
+    FILE* output_file = fopen("/spiffs/task_output", "w");
+    if (!output_file) {
+        printf("Failed to open the output file.\n");
+        return;
+    }
+
+    // One pass over the input, binning the points once the global min and max are known
+    if (LoadFileAnd2DBin("/spiffs/task_input", options.bPoints ? output_file : NULL, &options) == 0) {
+        Write2DBins(arg, output_file);
+    }
+    fclose(output_file);
+
+    printf("Job done\n");
+}
@@ -0,0 +1,53 @@
+// Tessie columns task
+// Minimum, maximum and mean of every column of a columnar payload, stored as a columnar output
+// Convert the input with: python3 tessie.py --to-columns samples.csv samples.tscl
+// Submit with: python3 tessie.py -b tessie_columns.elf -f samples.tscl -j stats
+// Read the output with: python3 tessie.py --from-columns tessie_results/stats-<hash>/0/0 stats.csv
+// (the path of the stored output as --results stats lists it)
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tessie_columns.h"
+
+#define BLOCK_ROWS 256  // Rows read at once, 2 KB of doubles
+
+static double values[BLOCK_ROWS];
+
+void local_main(const char* arg, size_t len) {
+    tessie_columns_t in, out;
+    static double minimum[TESSIE_COLUMNS_MAX], maximum[TESSIE_COLUMNS_MAX], mean[TESSIE_COLUMNS_MAX];
+    static int32_t index[TESSIE_COLUMNS_MAX];
+    static const char* const names[] = { "column", "min", "max", "mean" };
+    static const uint8_t types[] = { TESSIE_INT32, TESSIE_DOUBLE, TESSIE_DOUBLE, TESSIE_DOUBLE };
+
+    if (tessie_columns_open(&in, "/spiffs/task_input") != 0) {
+        return;
+    }
+    printf("%u rows of %u columns\n", in.rows, in.count);
+
+    for (int c = 0; c < in.count; c++) {
+        double sum = 0;
+        index[c] = c;
+        minimum[c] = maximum[c] = 0;
+        for (uint32_t row = 0; row < in.rows; row += BLOCK_ROWS) {
+            size_t n = tessie_columns_read_double(&in, c, row, BLOCK_ROWS, values);
+            for (size_t i = 0; i < n; i++) {
+                if (row + i == 0 || values[i] < minimum[c]) minimum[c] = values[i];
+                if (row + i == 0 || values[i] > maximum[c]) maximum[c] = values[i];
+                sum += values[i];
+            }
+        }
+        mean[c] = in.rows ? sum / in.rows : 0;
+        printf("%s: min %f max %f mean %f\n", in.columns[c].name, minimum[c], maximum[c], mean[c]);
+    }
+
+    if (tessie_columns_create(&out, "/spiffs/task_output", in.count, 4, names, types) == 0) {
+        tessie_columns_write(&out, 0, index, in.count);
+        tessie_columns_write(&out, 1, minimum, in.count);
+        tessie_columns_write(&out, 2, maximum, in.count);
+        tessie_columns_write(&out, 3, mean, in.count);
+        tessie_columns_close(&out);
+    }
+    tessie_columns_close(&in);
+}
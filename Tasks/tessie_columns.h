@@ -0,0 +1,293 @@
+// Tessie columnar files
+// Reads typed columns of a payload converted with `tessie.py --to-columns` straight into arrays,
+// and writes outputs the same way for `tessie.py --from-columns` to turn back into CSV
+// Header only, uses nothing beyond the stdio functions the node already exports
+//
+// File  : "TSCL", uint16 version, uint16 column count, uint32 row count, uint32 reserved
+// Column: char name[24], uint8 type, uint8 element size, uint16 reserved, uint32 data offset
+// Data  : every column's elements, each column starting at a multiple of 8 bytes
+// All integers are little-endian, the column data is read and written as is since every node is too
+//
+//   tessie_columns_t in;
+//   double values[256];
+//
+//   if (tessie_columns_open(&in, "/spiffs/task_input") != 0) return;
+//   int x = tessie_columns_find(&in, "x");
+//   for (uint32_t row = 0; row < in.rows; row += 256) {
+//       size_t n = tessie_columns_read_double(&in, x, row, 256, values);
+//       ...
+//   }
+//   tessie_columns_close(&in);
+#ifndef __TESSIE_COLUMNS__
+#define __TESSIE_COLUMNS__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TESSIE_COLUMNS_MAGIC "TSCL"
+#define TESSIE_COLUMNS_VERSION 1
+#define TESSIE_COLUMNS_MAX 16      // Most columns a file may have
+#define TESSIE_COLUMNS_NAME 24     // Bytes of a column name, NUL included
+#define TESSIE_COLUMNS_HEADER 16
+#define TESSIE_COLUMNS_ENTRY 32
+
+// Column types, the struct format characters the commander uses
+#define TESSIE_INT32 'i'
+#define TESSIE_INT64 'q'
+#define TESSIE_FLOAT 'f'
+#define TESSIE_DOUBLE 'd'
+
+typedef struct {
+    char name[TESSIE_COLUMNS_NAME];
+    uint8_t type;
+    uint8_t size;     // Bytes of one element
+    uint32_t offset;  // File offset of the first element
+} tessie_column_t;
+
+typedef struct {
+    FILE* file;
+    uint32_t rows;
+    uint16_t count;
+    tessie_column_t columns[TESSIE_COLUMNS_MAX];
+    int writing;   // Created as an output
+    uint32_t pos;  // Bytes of an output written so far
+    uint32_t end;  // Size of a complete output
+} tessie_columns_t;
+
+static inline uint32_t tessie_columns_get32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void tessie_columns_put32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+static inline uint8_t tessie_columns_type_size(uint8_t type) {
+    switch (type) {
+        case TESSIE_INT32:
+        case TESSIE_FLOAT:
+            return 4;
+        case TESSIE_INT64:
+        case TESSIE_DOUBLE:
+            return 8;
+    }
+    return 0;
+}
+
+// Open a columnar file and read its column table, returns 0 on success
+static inline int tessie_columns_open(tessie_columns_t* t, const char* path) {
+    uint8_t header[TESSIE_COLUMNS_HEADER];
+    uint8_t entry[TESSIE_COLUMNS_ENTRY];
+
+    memset(t, 0, sizeof(*t));
+    t->file = fopen(path, "r");
+    if (t->file == NULL) {
+        printf("Failed to open %s\n", path);
+        return 1;
+    }
+
+    if (fread(header, 1, sizeof(header), t->file) != sizeof(header) || memcmp(header, TESSIE_COLUMNS_MAGIC, 4) != 0 ||
+        (header[4] | (header[5] << 8)) != TESSIE_COLUMNS_VERSION) {
+        printf("Input is not a columnar file\n");
+        fclose(t->file);
+        return 1;
+    }
+    t->count = header[6] | (header[7] << 8);
+    t->rows = tessie_columns_get32(header + 8);
+    if (t->count > TESSIE_COLUMNS_MAX) {
+        printf("Too many columns: %u\n", t->count);
+        fclose(t->file);
+        return 1;
+    }
+
+    for (uint16_t i = 0; i < t->count; i++) {
+        tessie_column_t* c = &t->columns[i];
+        if (fread(entry, 1, sizeof(entry), t->file) != sizeof(entry)) {
+            printf("Column table truncated\n");
+            fclose(t->file);
+            return 1;
+        }
+        memcpy(c->name, entry, TESSIE_COLUMNS_NAME);
+        c->name[TESSIE_COLUMNS_NAME - 1] = '\0';
+        c->type = entry[24];
+        c->size = entry[25];
+        c->offset = tessie_columns_get32(entry + 28);
+        if (c->size == 0 || c->size != tessie_columns_type_size(c->type)) {
+            printf("Unknown type of column %s\n", c->name);
+            fclose(t->file);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Write zeros up to offset, the padding between and after columns
+static inline int tessie_columns_pad(tessie_columns_t* t, uint32_t offset) {
+    static const uint8_t zeros[64] = { 0 };
+    while (t->pos < offset) {
+        uint32_t n = offset - t->pos < sizeof(zeros) ? offset - t->pos : sizeof(zeros);
+        if (fwrite(zeros, 1, n, t->file) != n) {
+            return 1;
+        }
+        t->pos += n;
+    }
+    return 0;
+}
+
+// Close a file, an output is completed with zeros first
+static inline void tessie_columns_close(tessie_columns_t* t) {
+    if (t->file) {
+        if (t->writing) {
+            tessie_columns_pad(t, t->end);
+        }
+        fclose(t->file);
+        t->file = NULL;
+    }
+}
+
+// Index of the column called name, -1 if there is none
+static inline int tessie_columns_find(const tessie_columns_t* t, const char* name) {
+    for (int i = 0; i < t->count; i++) {
+        int k = 0;
+        while (k < TESSIE_COLUMNS_NAME && t->columns[i].name[k] == name[k] && name[k] != '\0') {
+            k++;
+        }
+        if (k < TESSIE_COLUMNS_NAME && t->columns[i].name[k] == name[k]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Read up to rows elements of a column from row first on, in the column's own type
+// Returns the number of elements read
+static inline size_t tessie_columns_read(tessie_columns_t* t, int column, uint32_t first, size_t rows, void* dst) {
+    if (column < 0 || column >= t->count || first >= t->rows) {
+        return 0;
+    }
+    const tessie_column_t* c = &t->columns[column];
+    if (rows > t->rows - first) {
+        rows = t->rows - first;
+    }
+    if (fseek(t->file, (long)c->offset + (long)first * c->size, SEEK_SET) != 0) {
+        return 0;
+    }
+    return fread(dst, c->size, rows, t->file);
+}
+
+// As tessie_columns_read, converting any column type to double
+static inline size_t tessie_columns_read_double(tessie_columns_t* t, int column, uint32_t first, size_t rows, double* dst) {
+    if (column < 0 || column >= t->count) {
+        return 0;
+    }
+    const tessie_column_t* c = &t->columns[column];
+    if (c->type == TESSIE_DOUBLE) {
+        return tessie_columns_read(t, column, first, rows, dst);
+    }
+
+    // Read into the end of dst and widen front to back, an element is read before its slot is overwritten
+    uint8_t* raw = (uint8_t*)dst + rows * (sizeof(double) - c->size);
+    size_t n = tessie_columns_read(t, column, first, rows, raw);
+    for (size_t i = 0; i < n; i++) {
+        const uint8_t* p = raw + i * c->size;
+        double v;
+        if (c->type == TESSIE_INT32) {
+            int32_t x;
+            memcpy(&x, p, sizeof(x));
+            v = x;
+        } else if (c->type == TESSIE_INT64) {
+            int64_t x;
+            memcpy(&x, p, sizeof(x));
+            v = (double)x;
+        } else {
+            float x;
+            memcpy(&x, p, sizeof(x));
+            v = x;
+        }
+        memcpy(&dst[i], &v, sizeof(v));
+    }
+    return n;
+}
+
+// Create a columnar output of count columns with rows rows each, returns 0 on success
+// The file is written front to back, as SPIFFS cannot seek past the end of a file: write the columns
+// in order with tessie_columns_write, rows a column is not given are left zero
+static inline int tessie_columns_create(tessie_columns_t* t, const char* path, uint32_t rows, uint16_t count,
+                                        const char* const* names, const uint8_t* types) {
+    uint8_t header[TESSIE_COLUMNS_HEADER] = { 0 };
+    uint8_t entry[TESSIE_COLUMNS_ENTRY];
+
+    memset(t, 0, sizeof(*t));
+    if (count > TESSIE_COLUMNS_MAX) {
+        printf("Too many columns: %u\n", count);
+        return 1;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        if (tessie_columns_type_size(types[i]) == 0) {
+            printf("Unknown type of column %s\n", names[i]);
+            return 1;
+        }
+    }
+    t->file = fopen(path, "w");
+    if (t->file == NULL) {
+        printf("Failed to open %s\n", path);
+        return 1;
+    }
+    t->rows = rows;
+    t->count = count;
+    t->writing = 1;
+
+    memcpy(header, TESSIE_COLUMNS_MAGIC, 4);
+    header[4] = TESSIE_COLUMNS_VERSION;
+    header[6] = count & 0xff;
+    header[7] = count >> 8;
+    tessie_columns_put32(header + 8, rows);
+    fwrite(header, 1, sizeof(header), t->file);
+
+    uint32_t offset = (TESSIE_COLUMNS_HEADER + TESSIE_COLUMNS_ENTRY * count + 7) & ~7u;
+    for (uint16_t i = 0; i < count; i++) {
+        tessie_column_t* c = &t->columns[i];
+        memset(entry, 0, sizeof(entry));
+        for (int k = 0; k < TESSIE_COLUMNS_NAME - 1 && names[i][k] != '\0'; k++) {
+            c->name[k] = entry[k] = names[i][k];
+        }
+        c->type = entry[24] = types[i];
+        c->size = entry[25] = tessie_columns_type_size(types[i]);
+        c->offset = offset;
+        tessie_columns_put32(entry + 28, c->offset);
+        fwrite(entry, 1, sizeof(entry), t->file);
+        offset = (offset + rows * c->size + 7) & ~7u;
+    }
+    t->pos = TESSIE_COLUMNS_HEADER + TESSIE_COLUMNS_ENTRY * count;
+    t->end = offset;
+    return 0;
+}
+
+// Append rows elements, in the column's own type, to a column of an output
+// Moving on to a later column completes the earlier ones. Returns the number of elements written
+static inline size_t tessie_columns_write(tessie_columns_t* t, int column, const void* src, size_t rows) {
+    if (!t->writing || column < 0 || column >= t->count) {
+        return 0;
+    }
+    const tessie_column_t* c = &t->columns[column];
+    uint32_t column_end = c->offset + t->rows * c->size;
+    if (t->pos < c->offset && tessie_columns_pad(t, c->offset) != 0) {
+        return 0;
+    }
+    if (t->pos >= column_end) {
+        printf("Column %s written already\n", c->name);
+        return 0;
+    }
+    if (rows > (column_end - t->pos) / c->size) {
+        rows = (column_end - t->pos) / c->size;
+    }
+    size_t n = fwrite(src, c->size, rows, t->file);
+    t->pos += n * c->size;
+    return n;
+}
+
+#endif /* __TESSIE_COLUMNS__ */
@@ -0,0 +1,280 @@
+// Tessie I/O helpers
+// Buffered reading of numbers and lines for tasks, a replacement for fscanf on large inputs
+// Header only, uses nothing beyond the stdio functions the node already exports
+//
+// The file is read in large blocks into a buffer the task provides, numbers are parsed straight
+// from the buffer and lines are handed out in place, so nothing is allocated per record:
+//
+//   static char buffer[4096];
+//   tessie_reader_t r;
+//   double v;
+//
+//   if (tessie_reader_open(&r, "/spiffs/task_input", buffer, sizeof(buffer)) != 0) return;
+//   while (tessie_read_double(&r, &v)) { ... }
+//   tessie_reader_close(&r);
+#ifndef __TESSIE_IO__
+#define __TESSIE_IO__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TESSIE_IO_TOKEN_MAX 64  // Longest number kept whole across block boundaries
+
+typedef struct {
+    FILE* file;
+    char* buf;    // Block buffer, one byte is kept for terminating lines
+    size_t size;  // Capacity of buf
+    size_t pos;   // Next unread byte in buf
+    size_t len;   // Bytes of buf filled
+    int eof;      // The file has no more bytes than those in buf
+} tessie_reader_t;
+
+// Open a file for reading through buf, returns 0 on success
+static inline int tessie_reader_open(tessie_reader_t* r, const char* path, char* buf, size_t size) {
+    memset(r, 0, sizeof(*r));
+    if (size < 2 * TESSIE_IO_TOKEN_MAX) {
+        printf("Reader buffer too small\n");
+        return 1;
+    }
+    r->file = fopen(path, "r");
+    if (r->file == NULL) {
+        printf("Failed to open %s\n", path);
+        return 1;
+    }
+    r->buf = buf;
+    r->size = size;
+    return 0;
+}
+
+static inline void tessie_reader_close(tessie_reader_t* r) {
+    if (r->file) {
+        fclose(r->file);
+        r->file = NULL;
+    }
+}
+
+// Start over from the beginning of the file, for a second pass without reopening it
+static inline void tessie_reader_rewind(tessie_reader_t* r) {
+    fseek(r->file, 0, SEEK_SET);
+    r->pos = r->len = 0;
+    r->eof = 0;
+}
+
+// Keep the unread bytes and fill the rest of the buffer, returns the number of unread bytes
+static inline size_t tessie_reader_fill(tessie_reader_t* r) {
+    size_t left = r->len - r->pos;
+    if (r->eof) {
+        return left;
+    }
+    if (r->pos > 0) {
+        memmove(r->buf, r->buf + r->pos, left);
+        r->pos = 0;
+        r->len = left;
+    }
+    size_t room = r->size - 1 - r->len;
+    size_t n = fread(r->buf + r->len, 1, room, r->file);
+    r->len += n;
+    if (n < room) {
+        r->eof = 1;
+    }
+    return r->len - r->pos;
+}
+
+// Read up to n raw bytes, returns the number read
+static inline size_t tessie_read_bytes(tessie_reader_t* r, void* dst, size_t n) {
+    size_t done = 0;
+    while (done < n) {
+        size_t left = r->len - r->pos;
+        if (left == 0) {
+            if (r->eof) {
+                break;
+            }
+            r->pos = r->len = 0;
+            if (n - done >= r->size) {
+                // Large reads go straight to the destination
+                size_t want = n - done;
+                size_t got = fread((char*)dst + done, 1, want, r->file);
+                done += got;
+                if (got < want) {
+                    r->eof = 1;
+                }
+                continue;
+            }
+            left = tessie_reader_fill(r);
+            if (left == 0) {
+                break;
+            }
+        }
+        size_t take = left < n - done ? left : n - done;
+        memcpy((char*)dst + done, r->buf + r->pos, take);
+        r->pos += take;
+        done += take;
+    }
+    return done;
+}
+
+// Next line without its end of line, NUL terminated in the buffer and valid until the next read
+// A line longer than the buffer is returned in pieces. Returns 0 at the end of the file
+static inline int tessie_read_line(tessie_reader_t* r, const char** line, size_t* len) {
+    size_t scanned = 0;
+    for (;;) {
+        char* start = r->buf + r->pos;
+        char* end = NULL;
+        for (char* c = start + scanned; c < r->buf + r->len; c++) {
+            if (*c == '\n') {
+                end = c;
+                break;
+            }
+        }
+        if (end != NULL || r->eof || r->len - r->pos == r->size - 1) {
+            size_t n = end ? (size_t)(end - start) : r->len - r->pos;
+            if (end == NULL && n == 0) {
+                return 0;
+            }
+            r->pos += n + (end ? 1 : 0);
+            if (n > 0 && start[n - 1] == '\r') {
+                n--;
+            }
+            start[n] = '\0';
+            *line = start;
+            *len = n;
+            return 1;
+        }
+        scanned = r->len - r->pos;
+        tessie_reader_fill(r);
+    }
+}
+
+// Skip blanks, line ends and the separators of CSV files, leave at least a whole token in the buffer
+// Returns 0 at the end of the file
+static inline int tessie_reader_skip(tessie_reader_t* r) {
+    for (;;) {
+        while (r->pos < r->len) {
+            char c = r->buf[r->pos];
+            if (c != ' ' && c != '\t' && c != '\r' && c != '\n' && c != ',' && c != ';') {
+                if (r->len - r->pos < TESSIE_IO_TOKEN_MAX && !r->eof) {
+                    tessie_reader_fill(r);
+                }
+                return 1;
+            }
+            r->pos++;
+        }
+        if (tessie_reader_fill(r) == 0) {
+            return 0;
+        }
+    }
+}
+
+// Next integer. Returns 0 at the end of the file or when the next token is not a number
+static inline int tessie_read_long(tessie_reader_t* r, long* value) {
+    if (!tessie_reader_skip(r)) {
+        return 0;
+    }
+    const char* p = r->buf + r->pos;
+    const char* end = r->buf + r->len;
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p++ == '-';
+    }
+    if (p == end || *p < '0' || *p > '9') {
+        return 0;
+    }
+    unsigned long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (unsigned long)(*p++ - '0');
+    }
+    *value = negative ? -(long)v : (long)v;
+    r->pos = p - r->buf;
+    return 1;
+}
+
+// Parse a floating point number, decimal with optional exponent, from p up to end
+// Up to 15 significant digits and exponents within 22 are converted exactly, as strtod would
+// Returns the first byte after the number, or NULL when p does not start with one
+static inline const char* tessie_parse_double(const char* p, const char* end, double* value) {
+    static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p++ == '-';
+    }
+
+    // Collect up to 19 significant digits, count the ones beyond in the exponent
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0, any = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            digits += mantissa != 0;
+        } else {
+            exponent++;
+        }
+        p++;
+        any = 1;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                digits += mantissa != 0;
+                exponent--;
+            }
+            p++;
+            any = 1;
+        }
+    }
+    if (!any) {
+        return NULL;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        int eneg = 0, e = 0;
+        if (q < end && (*q == '-' || *q == '+')) {
+            eneg = *q++ == '-';
+        }
+        if (q < end && *q >= '0' && *q <= '9') {
+            while (q < end && *q >= '0' && *q <= '9') {
+                if (e < 10000) {
+                    e = e * 10 + (*q - '0');
+                }
+                q++;
+            }
+            exponent += eneg ? -e : e;
+            p = q;
+        }
+    }
+
+    // Exact when the mantissa fits a double and the power of ten is exact too, else within an ulp or two
+    double v = (double)mantissa;
+    if (mantissa != 0) {
+        while (exponent > 22) {
+            v *= 1e22;
+            exponent -= 22;
+        }
+        while (exponent < -22) {
+            v /= 1e22;
+            exponent += 22;
+        }
+        v = exponent < 0 ? v / powers[-exponent] : v * powers[exponent];
+    }
+    *value = negative ? -v : v;
+    return p;
+}
+
+// Next floating point number, see tessie_parse_double
+// Returns 0 at the end of the file or when the next token is not a number
+static inline int tessie_read_double(tessie_reader_t* r, double* value) {
+    if (!tessie_reader_skip(r)) {
+        return 0;
+    }
+    const char* p = tessie_parse_double(r->buf + r->pos, r->buf + r->len, value);
+    if (p == NULL) {
+        return 0;
+    }
+    r->pos = p - r->buf;
+    return 1;
+}
+
+#endif /* __TESSIE_IO__ */